@@ -82,6 +82,15 @@ void nanos6_register_weak_readwrite_depinfo(void *handler, void *start, size_t l
 //! \param[in] length number of bytes until and including the last byte accessed
 void nanos6_register_weak_commutative_depinfo(void *handler, void *start, size_t length, int symbol_index);
 
+//! \brief Release the accesses of the current task that are reached through a symbol
+//!
+//! This informs the runtime that the task will not use the data of the symbol anymore, so its
+//! successors can start while the task keeps computing on other data. Accesses that are also
+//! reached through other symbols are only released once all of them have been released
+//!
+//! \param[in] symbol_index the index of the symbol passed to the register_depinfo functions
+void nanos6_release_symbol(int symbol_index);
+
 #ifdef __cplusplus
 }
 #endif
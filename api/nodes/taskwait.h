@@ -7,12 +7,14 @@
 #ifndef NODES_TASKWAIT_H
 #define NODES_TASKWAIT_H
 
+#include <stddef.h>
+
 #include "major.h"
 
 
 #pragma GCC visibility push(default)
 
-enum nanos6_taskwait_api_t { nanos6_taskwait_api = 3 };
+enum nanos6_taskwait_api_t { nanos6_taskwait_api = 4 };
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +25,34 @@ extern "C" {
 //! \param[in] invocation_source A string that identifies the source code location of the invocation
 void nanos6_taskwait(char const *invocation_source);
 
+//! \brief Block the control flow of the current task until the children that write a region have finished
+//!
+//! Children reading the region concurrently with the current task do not block it, and children
+//! created afterwards are ordered after the taskwait as if it were a child reading the region
+//!
+//! The accesses of the children are matched by their start address. If a child accesses part of
+//! the region from a different address, the call behaves as nanos6_taskwait. The same applies to
+//! nanos6_taskwait_out and nanos6_taskwait_inout
+//!
+//! \param[in] start first address of the region
+//! \param[in] length number of bytes of the region
+//! \param[in] invocation_source A string that identifies the source code location of the invocation
+void nanos6_taskwait_in(void *start, size_t length, char const *invocation_source);
+
+//! \brief Block the control flow of the current task until the children that access a region have finished
+//!
+//! \param[in] start first address of the region
+//! \param[in] length number of bytes of the region
+//! \param[in] invocation_source A string that identifies the source code location of the invocation
+void nanos6_taskwait_out(void *start, size_t length, char const *invocation_source);
+
+//! \brief Block the control flow of the current task until the children that access a region have finished
+//!
+//! \param[in] start first address of the region
+//! \param[in] length number of bytes of the region
+//! \param[in] invocation_source A string that identifies the source code location of the invocation
+void nanos6_taskwait_inout(void *start, size_t length, char const *invocation_source);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+//! Helpers shared by the microbenchmarks. Each result is printed to the standard output as
+//! a JSON object in its own line, so the output of several benchmarks can be concatenated.
+//! The amount of work can be scaled with NODES_BENCH_SCALE, and the number of measured
+//! repetitions set with NODES_BENCH_REPETITIONS
+class Benchmark {
+
+	const char *_name;
+	double _scale;
+	size_t _repetitions;
+
+public:
+
+	Benchmark(const char *name) :
+		_name(name),
+		_scale(1.0),
+		_repetitions(5)
+	{
+		const char *scale = std::getenv("NODES_BENCH_SCALE");
+		if (scale != nullptr && std::atof(scale) > 0.0)
+			_scale = std::atof(scale);
+
+		const char *repetitions = std::getenv("NODES_BENCH_REPETITIONS");
+		if (repetitions != nullptr && std::atol(repetitions) > 0)
+			_repetitions = std::atol(repetitions);
+	}
+
+	//! \brief Scale an amount of work
+	inline size_t scaled(size_t amount) const
+	{
+		return std::max((size_t) 1, (size_t) (amount * _scale));
+	}
+
+	//! \brief Run a function once to warm up and then measure the repetitions
+	//!
+	//! \returns The median time of the repetitions in seconds
+	template <typename F>
+	double measure(F function)
+	{
+		function();
+
+		std::vector<double> times;
+		for (size_t r = 0; r < _repetitions; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			times.push_back(std::chrono::duration<double>(end - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	//! \brief Print a result
+	inline void report(const char *metric, double value, const char *unit) const
+	{
+		std::printf("{\"benchmark\": \"%s\", \"metric\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"repetitions\": %zu}\n",
+			_name, metric, value, unit, _repetitions);
+		std::fflush(stdout);
+	}
+};
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,80 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the cost per task of chains of empty tasks that access the same variable with
+ * each access type. Writers are serialized, so their time includes the release latency
+ */
+
+#include "Benchmark.hpp"
+
+
+static size_t numTasks;
+static int variable;
+
+static void chainIn()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task in(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+static void chainOut()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task out(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+static void chainInout()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task inout(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+static void chainCommutative()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task commutative(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+static void chainConcurrent()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task concurrent(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("dependency-chain");
+	numTasks = benchmark.scaled(50000);
+
+	benchmark.report("in_time_per_task", benchmark.measure(chainIn) * 1e9 / numTasks, "ns");
+	benchmark.report("out_time_per_task", benchmark.measure(chainOut) * 1e9 / numTasks, "ns");
+	benchmark.report("inout_time_per_task", benchmark.measure(chainInout) * 1e9 / numTasks, "ns");
+	benchmark.report("commutative_time_per_task", benchmark.measure(chainCommutative) * 1e9 / numTasks, "ns");
+	benchmark.report("concurrent_time_per_task", benchmark.measure(chainConcurrent) * 1e9 / numTasks, "ns");
+
+	return 0;
+}
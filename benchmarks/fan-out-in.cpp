@@ -0,0 +1,50 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the release of wide fan-outs, where a writer satisfies many readers at once,
+ * and fan-ins, where a writer waits for many readers to release their accesses
+ */
+
+#include "Benchmark.hpp"
+
+
+#define WIDTH 1024
+
+static size_t numRounds;
+static int variable;
+
+static void fanOutIn()
+{
+	for (size_t r = 0; r < numRounds; ++r) {
+		#pragma oss task out(variable)
+		{
+		}
+
+		for (size_t w = 0; w < WIDTH; ++w) {
+			#pragma oss task in(variable)
+			{
+			}
+		}
+
+		#pragma oss task inout(variable)
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("fan-out-in");
+	numRounds = benchmark.scaled(100);
+
+	double seconds = benchmark.measure(fanOutIn);
+	benchmark.report("time_per_round", seconds * 1e6 / numRounds, "us");
+	benchmark.report("time_per_reader", seconds * 1e9 / (numRounds * WIDTH), "ns");
+
+	return 0;
+}
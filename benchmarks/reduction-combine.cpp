@@ -0,0 +1,44 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the bandwidth of array reductions, which includes the privatization of the
+ * array by each CPU and the combination of the private copies
+ */
+
+#include <nodes/debug.h>
+
+#include "Benchmark.hpp"
+
+
+#define N (2 * 1024 * 1024)
+
+static size_t numTasks;
+static double array[N];
+
+static void reduce()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task reduction(+: array)
+		{
+			for (size_t i = 0; i < N; ++i)
+				array[i] += 1.0;
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("reduction-combine");
+	numTasks = nanos6_get_num_cpus();
+
+	double seconds = benchmark.measure(reduce);
+	benchmark.report("reduced_bandwidth", (numTasks * sizeof(array)) / seconds / 1e9, "GB/s");
+	benchmark.report("time_per_reduction", seconds * 1e3, "ms");
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the throughput of spawning empty functions and waiting for their completion
+ */
+
+#include <atomic>
+
+#include <nodes/blocking.h>
+#include <nodes/library-mode.h>
+
+#include "Benchmark.hpp"
+
+
+static size_t numFunctions;
+static std::atomic<size_t> completed;
+
+static void emptyFunction(void *)
+{
+}
+
+static void completionCallback(void *)
+{
+	completed.fetch_add(1, std::memory_order_release);
+}
+
+static void spawnFunctions()
+{
+	completed.store(0, std::memory_order_relaxed);
+
+	for (size_t f = 0; f < numFunctions; ++f)
+		nanos6_spawn_function(emptyFunction, nullptr, completionCallback, nullptr, "benchmark");
+
+	// Yield the CPU in case the functions need it to run
+	while (completed.load(std::memory_order_acquire) < numFunctions)
+		nanos6_yield();
+}
+
+int main()
+{
+	Benchmark benchmark("spawn-function");
+	numFunctions = benchmark.scaled(50000);
+
+	double seconds = benchmark.measure(spawnFunctions);
+	benchmark.report("functions_per_second", numFunctions / seconds, "functions/s");
+
+	return 0;
+}
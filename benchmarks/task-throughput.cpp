@@ -0,0 +1,36 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the throughput of creating and submitting empty tasks without dependencies
+ */
+
+#include "Benchmark.hpp"
+
+
+static size_t numTasks;
+
+static void createTasks()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task
+		{
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("task-throughput");
+	numTasks = benchmark.scaled(100000);
+
+	double seconds = benchmark.measure(createTasks);
+	benchmark.report("tasks_per_second", numTasks / seconds, "tasks/s");
+	benchmark.report("time_per_task", seconds * 1e9 / numTasks, "ns");
+
+	return 0;
+}
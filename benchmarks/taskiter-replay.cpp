@@ -0,0 +1,55 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the cost per task of replaying a taskiter graph, compared with creating the same
+ * tasks and dependencies in every iteration
+ */
+
+#include "Benchmark.hpp"
+
+
+#define WIDTH 64
+
+static size_t numIterations;
+static int variables[WIDTH];
+
+static void taskiter()
+{
+	#pragma oss taskiter
+	for (size_t i = 0; i < numIterations; ++i) {
+		for (size_t j = 0; j < WIDTH; ++j) {
+			#pragma oss task inout(variables[j])
+			{
+			}
+		}
+	}
+	#pragma oss taskwait
+}
+
+static void regular()
+{
+	for (size_t i = 0; i < numIterations; ++i) {
+		for (size_t j = 0; j < WIDTH; ++j) {
+			#pragma oss task inout(variables[j])
+			{
+			}
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("taskiter-replay");
+	numIterations = benchmark.scaled(1000);
+
+	const size_t numTasks = numIterations * WIDTH;
+	benchmark.report("taskiter_time_per_task", benchmark.measure(taskiter) * 1e9 / numTasks, "ns");
+	benchmark.report("regular_time_per_task", benchmark.measure(regular) * 1e9 / numTasks, "ns");
+
+	return 0;
+}
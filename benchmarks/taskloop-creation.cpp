@@ -0,0 +1,42 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the cost of creating the chunks of taskloops with empty iterations, with the
+ * smallest grainsize and with the default one
+ */
+
+#include "Benchmark.hpp"
+
+
+static size_t numIterations;
+
+static void smallGrainsize()
+{
+	#pragma oss taskloop grainsize(1)
+	for (size_t i = 0; i < numIterations; ++i) {
+	}
+	#pragma oss taskwait
+}
+
+static void defaultGrainsize()
+{
+	#pragma oss taskloop
+	for (size_t i = 0; i < numIterations; ++i) {
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("taskloop-creation");
+	numIterations = benchmark.scaled(100000);
+
+	benchmark.report("grainsize_1_time_per_iteration", benchmark.measure(smallGrainsize) * 1e9 / numIterations, "ns");
+	benchmark.report("default_grainsize_time_per_iteration", benchmark.measure(defaultGrainsize) * 1e9 / numIterations, "ns");
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the latency of taskwaits, both without children and waiting for a single
+ * empty child that must be scheduled and completed first
+ */
+
+#include "Benchmark.hpp"
+
+
+static size_t numTaskwaits;
+
+static void emptyTaskwaits()
+{
+	for (size_t t = 0; t < numTaskwaits; ++t) {
+		#pragma oss taskwait
+	}
+}
+
+static void childTaskwaits()
+{
+	for (size_t t = 0; t < numTaskwaits; ++t) {
+		#pragma oss task
+		{
+		}
+		#pragma oss taskwait
+	}
+}
+
+int main()
+{
+	Benchmark benchmark("taskwait-latency");
+	numTaskwaits = benchmark.scaled(20000);
+
+	benchmark.report("empty_taskwait_latency", benchmark.measure(emptyTaskwaits) * 1e9 / numTaskwaits, "ns");
+	benchmark.report("child_taskwait_latency", benchmark.measure(childTaskwaits) * 1e9 / numTaskwaits, "ns");
+
+	return 0;
+}
@@ -0,0 +1,44 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Measure the throughput of a critical section contended by one task per CPU
+ */
+
+#include <nodes/debug.h>
+
+#include "Benchmark.hpp"
+
+
+static size_t numTasks;
+static size_t numAcquisitions;
+static long counter;
+
+static void contend()
+{
+	for (size_t t = 0; t < numTasks; ++t) {
+		#pragma oss task
+		{
+			for (size_t a = 0; a < numAcquisitions; ++a) {
+				#pragma oss critical
+				counter++;
+			}
+		}
+	}
+	#pragma oss taskwait
+}
+
+int main()
+{
+	Benchmark benchmark("user-mutex");
+	numTasks = nanos6_get_num_cpus();
+	numAcquisitions = benchmark.scaled(10000);
+
+	double seconds = benchmark.measure(contend);
+	benchmark.report("acquisitions_per_second", (numTasks * numAcquisitions) / seconds, "acquisitions/s");
+
+	return 0;
+}
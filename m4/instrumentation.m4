@@ -0,0 +1,32 @@
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+AC_DEFUN([AC_CHECK_INSTRUMENTATION],
+	[
+		AC_ARG_ENABLE(
+			[instrumentation],
+			[AS_HELP_STRING([--disable-instrumentation], [compile out every instrumentation point, including ovni and the Chrome traces])],
+			[ac_use_instrumentation="${enableval}"],
+			[ac_use_instrumentation="yes"]
+		)
+
+		instrumentation_CPPFLAGS=""
+
+		AC_MSG_CHECKING([whether to enable the instrumentation])
+		if test x"${ac_use_instrumentation}" = x"no" ; then
+			AC_MSG_RESULT([no])
+
+			if test x"${ac_use_ovni}" = x"yes" ; then
+				AC_MSG_WARN([ovni support is ignored since the instrumentation is disabled])
+			fi
+
+			# Every instrumentation point becomes an empty function
+			instrumentation_CPPFLAGS="-DDISABLE_INSTRUMENTATION"
+		else
+			AC_MSG_RESULT([yes])
+		fi
+
+		AC_SUBST([instrumentation_CPPFLAGS])
+	]
+)
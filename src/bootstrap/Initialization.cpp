@@ -10,18 +10,26 @@
 #include <nodes/bootstrap.h>
 #include <nodes/taskwait.h>
 
+#include "common/Chrono.hpp"
 #include "common/ErrorHandler.hpp"
 #include "dependencies/discrete/DependencySystem.hpp"
+#include "hardware/CPUContext.hpp"
 #include "hardware/HardwareInfo.hpp"
+#include "instrument/GraphRecorder.hpp"
 #include "instrument/OVNIInstrumentation.hpp"
+#include "instrument/Statistics.hpp"
 #include "system/SpawnFunction.hpp"
+#include "system/TaskCreation.hpp"
 #include "tasks/TaskInfo.hpp"
 
 
 void nanos6_init(void)
 {
-	// Initialize OVNI instrumentation
-	Instrument::initializeOvni();
+	// Calibrate the clock used for runtime measurements
+	Chrono::initialize();
+
+	// Initialize the instrumentation backends, which use the calibrated clock
+	Instrument::initialize();
 
 	// Initialize nOS-V backend
 	if (int err = nosv_init())
@@ -44,23 +52,45 @@ void nanos6_init(void)
 	// Gather hardware info
 	HardwareInfo::initialize();
 
+	// Initialize the runtime statistics, which are kept per CPU
+	Statistics::initialize();
+
+	// Initialize the graph recorder before the task types are created
+	GraphRecorder::initialize();
+
 	// Initialize the TaskInfo manager after nOS-V has been initialized
 	TaskInfo::initialize();
 
 	// Initialize the dependency system
 	DependencySystem::initialize();
+
+	// Initialize the task submission counters
+	TaskCreation::initialize();
 }
 
 void nanos6_shutdown(void)
 {
-	// TODO: Add nosv_sleep while waiting
-	while (SpawnFunction::_pendingSpawnedFunctions > 0) {
-		// Wait for spawned functions to fully end
-	}
+	// Wait for spawned functions to fully end
+	SpawnFunction::waitForSpawnedFunctions();
+
+	// Write the traces while the task type labels are still alive
+	Instrument::shutdown();
+
+	// Write the pending records of the task graph
+	GraphRecorder::shutdown();
+
+	// Shutdown the dependency system
+	DependencySystem::shutdown();
 
 	// Unregister any registered taskinfo from nOS-V
 	TaskInfo::shutdown();
 
+	// Shutdown the task submission counters
+	TaskCreation::shutdown();
+
+	// Report the runtime statistics
+	Statistics::shutdown();
+
 	// Shutdown hardware info
 	HardwareInfo::shutdown();
 
@@ -71,6 +101,9 @@ void nanos6_shutdown(void)
 	if (int err = nosv_detach(NOSV_DETACH_NONE))
 		ErrorHandler::fail("nosv_detach failed: ", nosv_get_error_string(err));
 
+	// The main thread is no longer a worker
+	CPUContext::invalidate();
+
 	// Shutdown nOS-V backend
 	if (int err = nosv_shutdown())
 		ErrorHandler::fail("nosv_shutdown failed: ", nosv_get_error_string(err));
@@ -0,0 +1,115 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <algorithm>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "Chrono.hpp"
+#include "EnvironmentVariable.hpp"
+
+
+bool Chrono::_useCycleCounter = false;
+std::atomic<uint64_t> Chrono::_nsPerCycle(0);
+uint64_t Chrono::_referenceNs = 0;
+uint64_t Chrono::_referenceCycles = 0;
+
+//! Time elapsed since the initialization after which the calibrated ratio is kept
+static constexpr uint64_t CALIBRATION_NS = 10 * 1000 * 1000;
+
+static inline uint64_t monotonicNanoseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+//! \brief Get the frequency of the cycle counter reported by the processor
+//!
+//! \returns The frequency in Hz, or 0 if it is unknown
+static inline uint64_t getCycleCounterFrequency()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	// The TSC can only be used as a clock if it ticks at a constant rate regardless of
+	// frequency changes and sleep states (CPUID.80000007H:EDX[8])
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1U << 8)))
+		return 0;
+
+	const unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+
+	// The TSC runs at a ratio of the core crystal clock (CPUID.15H), whose frequency may
+	// not be reported. In that case, the TSC runs at the base frequency (CPUID.16H)
+	if (maxLeaf >= 0x15) {
+		__cpuid(0x15, eax, ebx, ecx, edx);
+		if (eax != 0 && ebx != 0 && ecx != 0)
+			return ((uint64_t) ecx * ebx) / eax;
+	}
+
+	if (maxLeaf >= 0x16) {
+		__cpuid(0x16, eax, ebx, ecx, edx);
+		if ((eax & 0xFFFF) != 0)
+			return ((uint64_t) (eax & 0xFFFF)) * 1000000ULL;
+	}
+
+	// Invariant but unknown, so it has to be calibrated
+	return UINT64_MAX;
+#elif defined(__aarch64__)
+	// The virtual counter is invariant by definition and its frequency is architectural
+	uint64_t frequency;
+	__asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (frequency));
+	return frequency;
+#else
+	return 0;
+#endif
+}
+
+void Chrono::initialize()
+{
+	EnvironmentVariable<bool> useCycleCounter("NODES_CHRONO_CYCLE_COUNTER", true);
+	if (!useCycleCounter.getValue())
+		return;
+
+	const uint64_t frequency = getCycleCounterFrequency();
+	if (frequency == 0)
+		return;
+
+	_referenceNs = monotonicNanoseconds();
+	_referenceCycles = CycleCounter::read();
+
+	// Without a known frequency, the ratio is calibrated the first time it is needed
+	uint64_t nsPerCycle = 0;
+	if (frequency != UINT64_MAX) {
+		nsPerCycle = (1000000000ULL << 32) / frequency;
+		if (nsPerCycle == 0)
+			return;
+	}
+
+	_nsPerCycle.store(nsPerCycle, std::memory_order_relaxed);
+	_useCycleCounter = true;
+}
+
+uint64_t Chrono::calibrate()
+{
+	const uint64_t ns = monotonicNanoseconds();
+	const uint64_t cycles = CycleCounter::read();
+
+	// Too early to tell, so take cycles as nanoseconds
+	if (ns <= _referenceNs || cycles <= _referenceCycles)
+		return (1ULL << 32);
+
+	uint64_t nsPerCycle = (uint64_t) (((unsigned __int128) (ns - _referenceNs) << 32) / (cycles - _referenceCycles));
+	nsPerCycle = std::max(nsPerCycle, (uint64_t) 1);
+
+	// Keep the ratio once the interval is long enough to be precise. Until then, each
+	// conversion uses the most precise ratio so far
+	if (ns - _referenceNs >= CALIBRATION_NS)
+		_nsPerCycle.store(nsPerCycle, std::memory_order_relaxed);
+
+	return nsPerCycle;
+}
@@ -1,25 +1,73 @@
 /*
 	This file is part of NODES and is licensed under the terms contained in the COPYING file.
 
-	Copyright (C) 2021 Barcelona Supercomputing Center (BSC)
+	Copyright (C) 2021-2024 Barcelona Supercomputing Center (BSC)
 */
 
 #ifndef CHRONO_HPP
 #define CHRONO_HPP
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
 
+#include "CycleCounter.hpp"
 
+
+//! A chronometer with nanosecond resolution. It reads the cycle counter of the core when
+//! it is invariant, and falls back to clock_gettime otherwise
 class Chrono {
 
 private:
 
-	typedef std::chrono::steady_clock::time_point time_point_t;
+	//! Raw reading of the clock, in cycles or in nanoseconds
+	typedef uint64_t time_point_t;
 
 	time_point_t _chrono;
 
+	//! Accumulated time in nanoseconds
 	size_t _accumulated;
 
+	//! Whether the readings come from the cycle counter
+	static bool _useCycleCounter;
+
+	//! Nanoseconds per cycle as a 32.32 fixed-point number, or 0 while it is calibrated
+	static std::atomic<uint64_t> _nsPerCycle;
+
+	//! Readings of the monotonic clock and the cycle counter at the initialization, which
+	//! are the reference of the calibration and of the absolute times
+	static uint64_t _referenceNs;
+	static uint64_t _referenceCycles;
+
+	static inline time_point_t read()
+	{
+		if (_useCycleCounter)
+			return CycleCounter::read();
+
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ((uint64_t) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+	}
+
+	static inline uint64_t toNanoseconds(time_point_t ticks)
+	{
+		if (_useCycleCounter) {
+			uint64_t nsPerCycle = _nsPerCycle.load(std::memory_order_relaxed);
+			if (__builtin_expect(nsPerCycle == 0, 0))
+				nsPerCycle = calibrate();
+
+			return (uint64_t) (((unsigned __int128) ticks * nsPerCycle) >> 32);
+		}
+
+		return ticks;
+	}
+
+	//! \brief Compute the ratio of the cycle counter from the time elapsed since the
+	//! initialization, which is kept once enough time has elapsed to be precise
+	static uint64_t calibrate();
+
 public:
 
 	inline Chrono() :
@@ -32,15 +80,23 @@ public:
 	{
 	}
 
+	//! \brief Choose the clock, which must be done before taking any measure. The frequency
+	//! of the cycle counter is taken from the processor when it reports it, or calibrated
+	//! against the monotonic clock the first time it is needed otherwise
+	static void initialize();
 
 	inline void start()
 	{
-		_chrono = std::chrono::steady_clock::now();
+		_chrono = read();
 	}
 
 	inline void stop()
 	{
-		_accumulated += (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _chrono).count());
+		// The counter of the core where the thread resumed may be behind the one where
+		// it started, in which case the interval is discarded instead of wrapping around
+		const time_point_t end = read();
+		if (end > _chrono)
+			_accumulated += toNanoseconds(end - _chrono);
 	}
 
 	inline void restart()
@@ -58,7 +114,7 @@ public:
 	//! time gathered by the chronometer
 	inline operator double() const
 	{
-		return ((double) _accumulated);
+		return ((double) _accumulated) / 1000.0;
 	}
 
 	inline void operator+=(const Chrono& chrono)
@@ -66,20 +122,33 @@ public:
 		_accumulated += chrono.getAccumulated();
 	}
 
-	//! \brief Returns the accumulated ticks of this chronometer, not
-	//! converted to time
+	//! \brief Returns the accumulated time of this chronometer in nanoseconds
 	inline size_t getAccumulated() const
 	{
 		return _accumulated;
 	}
 
+	//! \brief Returns the current monotonic time in nanoseconds
+	static inline uint64_t nowNanoseconds()
+	{
+		if (_useCycleCounter) {
+			const time_point_t ticks = read();
+			if (ticks <= _referenceCycles)
+				return _referenceNs;
+
+			return _referenceNs + toNanoseconds(ticks - _referenceCycles);
+		}
+
+		return read();
+	}
+
 	//! \brief Returns the current monotonic time
 	template<typename T, class TimeUnit = std::micro>
 	static inline T now()
 	{
 		typedef std::chrono::duration<T, TimeUnit> duration;
-		const auto now = std::chrono::steady_clock::now();
-		return std::chrono::duration_cast<duration>(now.time_since_epoch()).count();
+		const std::chrono::nanoseconds now(nowNanoseconds());
+		return std::chrono::duration_cast<duration>(now).count();
 	}
 };
 
@@ -0,0 +1,43 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef CYCLE_COUNTER_HPP
+#define CYCLE_COUNTER_HPP
+
+#include <cstdint>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace CycleCounter {
+
+	//! \brief Read a cheap, monotonically increasing counter of the current core
+	//!
+	//! The units depend on the architecture (TSC cycles on x86, ticks of the virtual
+	//! counter on ARM, nanoseconds elsewhere), so readings are only meant to be compared
+	//! with each other, not converted to time
+	static inline uint64_t read()
+	{
+#if defined(__i386__) || defined(__x86_64__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t ticks;
+		__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (ticks));
+		return ticks;
+#else
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ((uint64_t) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+	}
+
+} // namespace CycleCounter
+
+#endif // CYCLE_COUNTER_HPP
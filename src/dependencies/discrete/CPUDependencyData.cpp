@@ -1,10 +1,11 @@
 /*
 	This file is part of NODES and is licensed under the terms contained in the COPYING file.
 
-	Copyright (C) 2021-2023 Barcelona Supercomputing Center (BSC)
+	Copyright (C) 2021-2024 Barcelona Supercomputing Center (BSC)
 */
 
 #include "CPUDependencyData.hpp"
 
 
-size_t TaskList::_actualChunkSize = 0;
+size_t CPUDependencyData::_satisfiedFlushThreshold = 0;
+size_t CPUDependencyData::_deletableFlushThreshold = 0;
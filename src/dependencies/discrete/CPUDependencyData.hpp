@@ -18,58 +18,45 @@
 #include "tasks/TaskMetadata.hpp"
 
 
+//! A growable list of tasks pending to be processed by the dependency system
 class TaskList {
 
-public:
-
-	static size_t _actualChunkSize;
-
 private:
 
-	static constexpr size_t MAX_CHUNKSIZE = 256;
-
-	TaskMetadata *_array[MAX_CHUNKSIZE];
-
-	size_t _count;
+	Container::vector<TaskMetadata *> _array;
 
 public:
 
 	inline TaskList() :
-		_count(0)
+		_array()
 	{
 	}
 
 	inline size_t size() const
 	{
-		return _count;
+		return _array.size();
 	}
 
 	inline void clear()
 	{
-		_count = 0;
+		// Keeps the capacity, so the list only grows up to the largest flush
+		_array.clear();
 	}
 
 	inline void add(TaskMetadata *task)
 	{
-		assert(_count < _actualChunkSize);
-
-		_array[_count++] = task;
+		_array.push_back(task);
 	}
 
 	inline TaskMetadata *get(size_t pos)
 	{
-		assert(pos < _count);
+		assert(pos < _array.size());
 		return _array[pos];
 	}
 
 	inline TaskMetadata **getArray()
 	{
-		return &_array[0];
-	}
-
-	static inline size_t getMaxChunkSize()
-	{
-		return MAX_CHUNKSIZE;
+		return _array.data();
 	}
 };
 
@@ -87,6 +74,13 @@ struct CPUDependencyData {
 	commutative_satisfied_list_t _satisfiedCommutativeOriginators;
 	mailbox_t _mailBox;
 
+	//! Number of satisfied originators after which they are submitted, even in the middle
+	//! of releasing accesses (SIZE_MAX to only submit them at the end)
+	static size_t _satisfiedFlushThreshold;
+
+	//! Number of deletable originators after which they are disposed
+	static size_t _deletableFlushThreshold;
+
 #ifndef NDEBUG
 	std::atomic<bool> _inUse;
 #endif
@@ -124,7 +118,6 @@ struct CPUDependencyData {
 	{
 		assert(task != nullptr);
 		assert(deviceType == nanos6_host_device);
-		assert(_satisfiedOriginatorCount < (size_t) task_list_t::_actualChunkSize);
 
 		_satisfiedOriginatorCount++;
 		_satisfiedOriginators[deviceType].add(task);
@@ -133,20 +126,24 @@ struct CPUDependencyData {
 	inline void addDeletableOriginator(TaskMetadata *task)
 	{
 		assert(task != nullptr);
-		assert(_deletableOriginators.size() < (size_t) task_list_t::_actualChunkSize);
 		_deletableOriginators.add(task);
 	}
 
+	inline size_t getSatisfiedOriginatorCount() const
+	{
+		return _satisfiedOriginatorCount;
+	}
+
 	inline bool fullSatisfiedOriginators() const
 	{
-		assert(task_list_t::_actualChunkSize != 0);
-		return (_satisfiedOriginatorCount == task_list_t::_actualChunkSize);
+		assert(_satisfiedFlushThreshold != 0);
+		return (_satisfiedOriginatorCount >= _satisfiedFlushThreshold);
 	}
 
 	inline bool fullDeletableOriginators() const
 	{
-		assert(task_list_t::_actualChunkSize != 0);
-		return (_deletableOriginators.size() == task_list_t::_actualChunkSize);
+		assert(_deletableFlushThreshold != 0);
+		return (_deletableOriginators.size() >= _deletableFlushThreshold);
 	}
 
 	inline task_list_t &getSatisfiedOriginators(int device)
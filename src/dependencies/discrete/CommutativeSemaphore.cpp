@@ -10,6 +10,7 @@
 #include "CPUDependencyData.hpp"
 #include "DataAccessRegistration.hpp"
 #include "TaskDataAccesses.hpp"
+#include "instrument/Statistics.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
@@ -30,6 +31,7 @@ bool CommutativeSemaphore::registerTask(TaskMetadata *task)
 	}
 
 	_waitingTasks.emplace_back(std::forward<TaskMetadata *>(task));
+	Statistics::increment(Statistics::COMMUTATIVE_WAITS);
 	return false;
 }
 
@@ -166,6 +166,18 @@ public:
 			_accessFlags.fetch_and(~ACCESS_IS_WEAK, std::memory_order_relaxed);
 	}
 
+	//! \brief Whether this is a pseudo-access registered by a taskwait on dependencies, in
+	//! which case the originator is the task that waits instead of a child task
+	inline bool isTaskwaitFragment() const
+	{
+		return (_accessFlags.load(std::memory_order_relaxed) & ACCESS_IS_TASKWAIT);
+	}
+
+	inline void markAsTaskwaitFragment()
+	{
+		_accessFlags.fetch_or(ACCESS_IS_TASKWAIT, std::memory_order_relaxed);
+	}
+
 	inline size_t getLength() const
 	{
 		return _region.getSize();
@@ -221,6 +233,11 @@ public:
 		_symbols.set(symbol);
 	}
 
+	void removeFromSymbol(int symbol)
+	{
+		_symbols.reset(symbol);
+	}
+
 	symbols_t getSymbols() const
 	{
 		return _symbols;
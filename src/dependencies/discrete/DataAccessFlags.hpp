@@ -42,6 +42,7 @@ struct DataAccess;
 #define ACCESS_NEXTISPARENT                    BIT(20)     // Next = parent access
 #define ACCESS_REDUCTION_COMBINED              BIT(21)     // Combination checked
 #define ACCESS_IS_WEAK                         BIT(22)     // Is a weak access (non-atomic, just to save space)
+#define ACCESS_IS_TASKWAIT                     BIT(23)     // Is a taskwait fragment (non-atomic, just to save space)
 
 typedef uint32_t access_flags_t;
 
@@ -16,7 +16,9 @@
 #include "TaskDataAccesses.hpp"
 #include "TaskiterReductionInfo.hpp"
 #include "common/ErrorHandler.hpp"
+#include "instrument/GraphRecorder.hpp"
 #include "instrument/OVNIInstrumentation.hpp"
+#include "instrument/Statistics.hpp"
 #include "memory/ObjectAllocator.hpp"
 #include "system/TaskFinalization.hpp"
 #include "taskiter/TaskiterGraph.hpp"
@@ -47,9 +49,14 @@ namespace DataAccessRegistration {
 	static inline void decreaseDeletableCountOrDelete(TaskMetadata *originator,
 		CPUDependencyData &hpDependencyData);
 
+	static inline void disposeAccess(DataAccess *access, CPUDependencyData &hpDependencyData);
+
 	//! Process all the originators that have become ready
 	static inline void processSatisfiedOriginators(CPUDependencyData &hpDependencyData, bool fromBusyThread)
 	{
+		if (hpDependencyData.getSatisfiedOriginatorCount() > 0)
+			Statistics::record(Statistics::SATISFIED_FLUSH_SIZE, hpDependencyData.getSatisfiedOriginatorCount());
+
 		// In NODES the last task is the immediate successor.
 		// This differs from the Nanos6 runtime where we choose the first task with highest priority.
 		// This implementation choice has been taken because it allows an easier implementation of
@@ -159,6 +166,9 @@ namespace DataAccessRegistration {
 		TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
 		assert(!accessStruct.hasBeenDeleted());
 
+		if (GraphRecorder::isEnabled())
+			GraphRecorder::recordAccess(task, accessType, weak, address, length);
+
 		bool alreadyExisting;
 		DataAccess *access = accessStruct.allocateAccess(address, accessType, task, length, weak, alreadyExisting);
 		if (!alreadyExisting) {
@@ -198,12 +208,11 @@ namespace DataAccessRegistration {
 
 			if (next.to != nullptr && next.flagsForNext) {
 				if (next.to->apply(next, mailBox)) {
-					TaskMetadata *task = next.to->getOriginator();
-					TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
-					assert(!accessStruct.hasBeenDeleted());
+					__attribute__((unused)) TaskMetadata *task = next.to->getOriginator();
+					assert(!task->getTaskDataAccesses().hasBeenDeleted());
 					assert(next.to != next.from);
 
-					decreaseDeletableCountOrDelete(task, hpDependencyData);
+					disposeAccess(next.to, hpDependencyData);
 				}
 			}
 
@@ -214,7 +223,11 @@ namespace DataAccessRegistration {
 				TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
 				assert(!accessStruct.hasBeenDeleted());
 
-				satisfyTask(task, hpDependencyData, fromBusyThread);
+				if (next.from->isTaskwaitFragment()) {
+					releaseTaskwaitFragment(task, next.from->getAccessRegion(), hpDependencyData);
+				} else {
+					satisfyTask(task, hpDependencyData, fromBusyThread);
+				}
 			}
 
 			if (next.combine) {
@@ -242,11 +255,10 @@ namespace DataAccessRegistration {
 			}
 
 			if (dispose) {
-				TaskMetadata *task = next.from->getOriginator();
-				TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
-				assert(!accessStruct.hasBeenDeleted());
+				__attribute__((unused)) TaskMetadata *task = next.from->getOriginator();
+				assert(!task->getTaskDataAccesses().hasBeenDeleted());
 
-				decreaseDeletableCountOrDelete(task, hpDependencyData);
+				disposeAccess(next.from, hpDependencyData);
 			}
 		}
 	}
@@ -318,6 +330,8 @@ namespace DataAccessRegistration {
 		// register_depinfo, to later insert them into the chain in the insertAccesses call
 		assert(task != nullptr);
 
+		Statistics::increment(Statistics::DEPENDENCY_REGISTRATIONS);
+
 #ifndef NDEBUG
 		{
 			bool alreadyTaken = false;
@@ -331,7 +345,15 @@ namespace DataAccessRegistration {
 		// This part creates the DataAccesses and inserts it to dependency system
 		task->registerDependencies();
 
-		insertAccesses(task, hpDependencyData);
+		// Children of taskloops generated in parallel are inserted concurrently in the bottom map
+		TaskMetadata *parent = task->getParent();
+		SpinLock *registrationLock = (parent != nullptr) ? parent->getChildRegistrationLock() : nullptr;
+		if (registrationLock != nullptr) {
+			std::lock_guard<SpinLock> guard(*registrationLock);
+			insertAccesses(task, hpDependencyData);
+		} else {
+			insertAccesses(task, hpDependencyData);
+		}
 
 		TaskDataAccesses &accessStructures = task->getTaskDataAccesses();
 		assert(!accessStructures.hasBeenDeleted());
@@ -371,7 +393,7 @@ namespace DataAccessRegistration {
 			m.from = m.to = access;
 			m.flagsAfterPropagation = ACCESS_PARENT_DONE;
 			if (access->applyPropagated(m)) {
-				decreaseDeletableCountOrDelete(access->getOriginator(), hpDependencyData);
+				disposeAccess(access, hpDependencyData);
 			}
 
 			ReductionInfo *reductionInfo = itMap->second._reductionInfo;
@@ -611,6 +633,51 @@ namespace DataAccessRegistration {
 		}
 	}
 
+	//! Link a newly registered access to the chain of its address, either as the successor of the last
+	//! access in the bottom map of the parent or as the first child of the parent access. Returns the
+	//! message that the access generated when receiving the satisfiability of its predecessor
+	static inline DataAccessMessage linkAccess(
+		DataAccess *access,
+		DataAccess *predecessor,
+		DataAccess *parentAccess,
+		CPUDependencyData &hpDependencyData)
+	{
+		mailbox_t &mailBox = hpDependencyData._mailBox;
+		DataAccessMessage fromCurrent;
+
+		if (predecessor == nullptr) {
+			if (parentAccess != nullptr) {
+				parentAccess->setChild(access);
+
+				DataAccessMessage message = parentAccess->applySingle(ACCESS_HASCHILD, mailBox);
+				fromCurrent = access->applySingle(message.flagsForNext, mailBox);
+				assert(!(fromCurrent.flagsForNext));
+
+				bool dispose = parentAccess->applyPropagated(message);
+				assert(!dispose);
+
+				if (dispose)
+					decreaseDeletableCountOrDelete(parentAccess->getOriginator(), hpDependencyData);
+			} else {
+				fromCurrent = access->applySingle(
+					ACCESS_READ_SATISFIED | ACCESS_WRITE_SATISFIED | ACCESS_CONCURRENT_SATISFIED | ACCESS_COMMUTATIVE_SATISFIED,
+					mailBox);
+				fromCurrent.schedule = true;
+			}
+		} else {
+			predecessor->setSuccessor(access);
+
+			DataAccessMessage message = predecessor->applySingle(ACCESS_HASNEXT, mailBox);
+			fromCurrent = access->applySingle(message.flagsForNext, mailBox);
+			assert(!(fromCurrent.flagsForNext));
+
+			if (predecessor->applyPropagated(message))
+				disposeAccess(predecessor, hpDependencyData);
+		}
+
+		return fromCurrent;
+	}
+
 	static inline void insertAccesses(TaskMetadata *task, CPUDependencyData &hpDependencyData)
 	{
 		TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
@@ -623,8 +690,7 @@ namespace DataAccessRegistration {
 
 		const bool isTaskiterChild = parentTask->isTaskiter();
 
-		mailbox_t &mailBox = hpDependencyData._mailBox;
-		assert(mailBox.empty());
+		assert(hpDependencyData._mailBox.empty());
 
 		// Default deletableCount of 1, plus one for each non-duplicate access
 		accessStruct.increaseDeletableCount(1 + accessStruct.getRealAccessNumber());
@@ -706,38 +772,8 @@ namespace DataAccessRegistration {
 				entry._reductionInfo = nullptr;
 			}
 
-			if (predecessor == nullptr) {
-				if (parentAccess != nullptr) {
-					parentAccess->setChild(access);
-
-					DataAccessMessage message = parentAccess->applySingle(ACCESS_HASCHILD, mailBox);
-					fromCurrent = access->applySingle(message.flagsForNext, mailBox);
-					schedule = fromCurrent.schedule;
-					assert(!(fromCurrent.flagsForNext));
-
-					dispose = parentAccess->applyPropagated(message);
-					assert(!dispose);
-
-					if (dispose)
-						decreaseDeletableCountOrDelete(parentTask, hpDependencyData);
-				} else {
-					schedule = true;
-					fromCurrent = access->applySingle(
-						ACCESS_READ_SATISFIED | ACCESS_WRITE_SATISFIED | ACCESS_CONCURRENT_SATISFIED | ACCESS_COMMUTATIVE_SATISFIED,
-						mailBox);
-				}
-			} else {
-				predecessor->setSuccessor(access);
-
-				DataAccessMessage message = predecessor->applySingle(ACCESS_HASNEXT, mailBox);
-				fromCurrent = access->applySingle(message.flagsForNext, mailBox);
-				schedule = fromCurrent.schedule;
-				assert(!(fromCurrent.flagsForNext));
-
-				dispose = predecessor->applyPropagated(message);
-				if (dispose)
-					decreaseDeletableCountOrDelete(predecessor->getOriginator(), hpDependencyData);
-			}
+			fromCurrent = linkAccess(access, predecessor, parentAccess, hpDependencyData);
+			schedule = fromCurrent.schedule;
 
 			if (fromCurrent.combine) {
 				assert(access->getType() == REDUCTION_ACCESS_TYPE);
@@ -802,6 +838,26 @@ namespace DataAccessRegistration {
 		}
 	}
 
+	static inline void disposeAccess(DataAccess *access, CPUDependencyData &hpDependencyData)
+	{
+		TaskMetadata *originator = access->getOriginator();
+
+		if (access->isTaskwaitFragment()) {
+			// Taskwait fragments are not part of the access structures of their task, but they
+			// prevent it from being disposed while they are alive
+			ObjectAllocator<DataAccess>::deleteObject(access);
+
+			if (originator->decreaseRemovalBlockingCount()) {
+				hpDependencyData.addDeletableOriginator(originator);
+
+				if (hpDependencyData.fullDeletableOriginators())
+					processDeletableOriginators(hpDependencyData);
+			}
+		} else {
+			decreaseDeletableCountOrDelete(originator, hpDependencyData);
+		}
+	}
+
 	static inline ReductionInfo *allocateReductionInfo(
 		__unused DataAccessType &dataAccessType, reduction_index_t reductionIndex,
 		reduction_type_and_operator_index_t reductionTypeAndOpIndex,
@@ -899,6 +955,39 @@ namespace DataAccessRegistration {
 		});
 	}
 
+	//! Whether the accesses of a task can be released before it finishes. Taskiter children only go through
+	//! the access chains during the first iteration; afterwards their successors are driven by the task-granular
+	//! and transitively reduced graph, so an early release is deferred until the task completes
+	static inline bool supportsEarlyRelease(TaskMetadata *task)
+	{
+		TaskMetadata *parentTask = task->getParent();
+		assert(parentTask != nullptr);
+
+		return !parentTask->isTaskiter() || task->getOriginalPrecessorCount() < 0;
+	}
+
+	//! Release a single access of a task that has not finished yet. The messages are propagated
+	//! through hpDependencyData, but the satisfied and deletable originators are left to the caller
+	static inline void releaseAccess(
+		TaskMetadata *task,
+		DataAccess *access,
+		void *address,
+		size_t cpuId,
+		CPUDependencyData &hpDependencyData)
+	{
+		assert(!access->isReleased());
+
+		// Release reduction storage before finalizing, as we might delete the ReductionInfo later
+		if (access->getType() == REDUCTION_ACCESS_TYPE && !access->isWeak()) {
+			ReductionInfo *reductionInfo = access->getReductionInfo();
+			assert(reductionInfo != nullptr);
+
+			reductionInfo->releaseSlotsInUse(task, cpuId);
+		}
+
+		finalizeDataAccess(task, access, address, hpDependencyData, true);
+	}
+
 	void releaseAccessRegion(
 		TaskMetadata *task,
 		void *address,
@@ -920,9 +1009,6 @@ namespace DataAccessRegistration {
 		}
 #endif
 
-		// Partial release not supported inside a taskiter construct
-		assert(task->getParent() && !task->getParent()->isTaskiter());
-
 		if (accessStruct.hasDataAccesses()) {
 			// Release dependencies of all my accesses
 			DataAccess *access = accessStruct.findAccess(address);
@@ -934,15 +1020,11 @@ namespace DataAccessRegistration {
 			ErrorHandler::failIf(access->getType() != accessType || access->isWeak() != weak,
 				"It is not possible to partially release a dependence.");
 
-			// Release reduction storage before finalizing, as we might delete the ReductionInfo later
-			if (access->getType() == REDUCTION_ACCESS_TYPE && !access->isWeak()) {
-				ReductionInfo *reductionInfo = access->getReductionInfo();
-				assert(reductionInfo != nullptr);
-
-				reductionInfo->releaseSlotsInUse(task, cpuId);
+			// Taskiter reductions are combined once per iteration, so they are always released at the end
+			if (supportsEarlyRelease(task) && !access->isReleased()
+				&& !(access->getType() == REDUCTION_ACCESS_TYPE && task->getParent()->isTaskiter())) {
+				releaseAccess(task, access, address, cpuId, hpDependencyData);
 			}
-
-			finalizeDataAccess(task, access, address, hpDependencyData, true);
 		} else {
 			ErrorHandler::fail("Attempt to release an access that was not originally registered in the task");
 		}
@@ -961,13 +1043,178 @@ namespace DataAccessRegistration {
 #endif
 	}
 
+	void releaseSymbolAccesses(
+		TaskMetadata *task,
+		int symbolIndex,
+		size_t cpuId,
+		CPUDependencyData &hpDependencyData)
+	{
+		assert(task != nullptr);
+		assert(hpDependencyData._mailBox.empty());
+
+		TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
+		assert(!accessStruct.hasBeenDeleted());
+
+		// Successive iterations of a taskiter child cannot release anything before completing
+		if (!accessStruct.hasDataAccesses() || !supportsEarlyRelease(task))
+			return;
+
+		Instrument::enterUnregisterAccesses();
+
+#ifndef NDEBUG
+		{
+			bool alreadyTaken = false;
+			assert(hpDependencyData._inUse.compare_exchange_strong(alreadyTaken, true));
+		}
+#endif
+
+		const bool taskiterChild = task->getParent()->isTaskiter();
+
+		// An access may be reached through several symbols, and it can only be released once the task
+		// is done with all of them. The successors that become ready are accumulated in hpDependencyData
+		// and submitted in a single batch once every access of the symbol has been released
+		accessStruct.forAll([&](void *address, DataAccess *access) -> bool {
+			if (!access->isInSymbol(symbolIndex) || access->isReleased())
+				return true;
+
+			// Taskiter reductions are combined once per iteration and keep their symbols for the
+			// address translation of the following iterations, so they are released at the end
+			if (taskiterChild && access->getType() == REDUCTION_ACCESS_TYPE)
+				return true;
+
+			access->removeFromSymbol(symbolIndex);
+			if (access->getSymbols().none())
+				releaseAccess(task, access, address, cpuId, hpDependencyData);
+
+			return true; // Continue iteration
+		});
+
+		processSatisfiedOriginators(hpDependencyData, true);
+		processDeletableOriginators(hpDependencyData);
+
+#ifndef NDEBUG
+		{
+			bool alreadyTaken = true;
+			assert(hpDependencyData._inUse.compare_exchange_strong(alreadyTaken, false));
+		}
+#endif
+
+		Instrument::exitUnregisterAccesses();
+	}
+
+	bool isTaskwaitRegionExact(TaskMetadata *task, void *address, size_t length)
+	{
+		assert(task != nullptr);
+
+		TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
+		assert(!accessStruct.hasBeenDeleted());
+
+		// Only the task itself adds entries to its bottom map, and the accesses in it are kept
+		// until a successor is linked after them
+		const DataAccessRegion region(address, length);
+		for (const auto &it : accessStruct._subaccessBottomMap) {
+			const DataAccess *access = it.second._access;
+			if (it.first == address || access == nullptr)
+				continue;
+
+			if (!access->getAccessRegion().intersect(region).empty())
+				return false;
+		}
+
+		return true;
+	}
+
+	bool registerTaskwaitFragment(
+		TaskMetadata *task,
+		void *address,
+		size_t length,
+		DataAccessType accessType,
+		CPUDependencyData &hpDependencyData)
+	{
+		assert(task != nullptr);
+		assert(address != nullptr);
+		assert(accessType == READ_ACCESS_TYPE || accessType == READWRITE_ACCESS_TYPE);
+		assert(!task->isTaskiter() && !task->isTaskiterChild());
+
+		TaskDataAccesses &accessStruct = task->getTaskDataAccesses();
+		assert(!accessStruct.hasBeenDeleted());
+		assert(hpDependencyData._mailBox.empty());
+
+#ifndef NDEBUG
+		{
+			bool alreadyTaken = false;
+			assert(hpDependencyData._inUse.compare_exchange_strong(alreadyTaken, true));
+		}
+#endif
+
+		// The fragment is a regular access of the task placed after the last child access of the region,
+		// so it becomes satisfied exactly when a successor of those children would. It does not need the
+		// predecessors of the task because a running task has none, so the task reuses that counter to
+		// wait. The extra predecessor avoids being woken up before we decide whether we have to block
+		DataAccess *fragment = ObjectAllocator<DataAccess>::newObject(accessType, task, address, length, false);
+		fragment->markAsTaskwaitFragment();
+
+		task->increaseRemovalBlockingCount();
+		task->increasePredecessors(2);
+
+		BottomMapEntry &entry = accessStruct._subaccessBottomMap[address];
+		DataAccess *predecessor = entry._access;
+		entry._access = fragment;
+
+		// Waiting on the region closes the reductions of the children
+		ReductionInfo *reductionInfo = entry._reductionInfo;
+		entry._reductionInfo = nullptr;
+
+		DataAccess *parentAccess = nullptr;
+		if (predecessor == nullptr)
+			parentAccess = accessStruct.findAccess(address);
+
+		DataAccessMessage fromCurrent = linkAccess(fragment, predecessor, parentAccess, hpDependencyData);
+		if (!fromCurrent.schedule)
+			task->increasePredecessors();
+
+		if (reductionInfo != nullptr && reductionInfo->markAsClosed())
+			releaseReductionInfo(reductionInfo);
+
+		// Nothing else waits on the fragment, so it is unregistered right away and the children created
+		// after the taskwait are linked after it as if it were a finished sibling
+		DataAccessMessage message;
+		message.to = message.from = fragment;
+		message.flagsForNext = ACCESS_UNREGISTERED | ACCESS_CHILD_WRITE_DONE | ACCESS_CHILD_READ_DONE
+			| ACCESS_CHILD_CONCURRENT_DONE | ACCESS_CHILD_COMMUTATIVE_DONE;
+
+		mailbox_t &mailBox = hpDependencyData._mailBox;
+		__attribute__((unused)) bool dispose = fragment->apply(message, mailBox);
+		assert(!dispose);
+
+		if (!mailBox.empty())
+			propagateMessages(hpDependencyData, mailBox, nullptr, true);
+
+		processSatisfiedOriginators(hpDependencyData, true);
+		processDeletableOriginators(hpDependencyData);
+
+#ifndef NDEBUG
+		{
+			bool alreadyTaken = true;
+			assert(hpDependencyData._inUse.compare_exchange_strong(alreadyTaken, false));
+		}
+#endif
+
+		return task->decreasePredecessors(2);
+	}
+
 	void releaseTaskwaitFragment(
-		__attribute__((unused)) TaskMetadata *task,
+		TaskMetadata *task,
 		__attribute__((unused)) DataAccessRegion region,
-		__attribute__((unused)) size_t cpuId,
 		__attribute__((unused)) CPUDependencyData &hpDependencyData)
 	{
-		assert(false);
+		assert(task != nullptr);
+
+		// The task is paused in the taskwait, or about to be
+		if (task->decreasePredecessors()) {
+			if (int err = nosv_submit(task->getTaskHandle(), NOSV_SUBMIT_UNLOCKED))
+				ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
+		}
 	}
 
 	bool supportsDataTracking()
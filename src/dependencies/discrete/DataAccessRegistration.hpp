@@ -52,6 +52,18 @@ namespace DataAccessRegistration {
 		size_t cpuId,
 		CPUDependencyData &hpDependencyData);
 
+	//! \brief Releases the accesses of a task that are only reachable through a symbol
+	//!
+	//! \param[in] task the task that has stopped using the symbol
+	//! \param[in] symbolIndex the index of the symbol that will not be used anymore
+	//! \param[in] cpuId the CPU where the task is running
+	//! \param[in] hpDependencyData the CPUDependencyData where the successors are batched
+	void releaseSymbolAccesses(
+		TaskMetadata *task,
+		int symbolIndex,
+		size_t cpuId,
+		CPUDependencyData &hpDependencyData);
+
 	void handleEnterTaskwait(TaskMetadata *task);
 	void handleExitTaskwait(TaskMetadata *task);
 
@@ -62,6 +74,33 @@ namespace DataAccessRegistration {
 	template <typename ProcessorType>
 	inline bool processAllDataAccesses(TaskMetadata *task, ProcessorType processor);
 
+	//! \brief Check whether the accesses of the children of a task that overlap a region start at
+	//! the same address, which is the only way a taskwait fragment can be linked after them
+	//!
+	//! \param[in] task is the Task that performs the taskwait
+	//! \param[in] address is the starting address of the region
+	//! \param[in] length is the length of the region
+	//!
+	//! \returns false if some child access overlaps the region from another address
+	bool isTaskwaitRegionExact(TaskMetadata *task, void *address, size_t length);
+
+	//! \brief Register a taskwait fragment that waits for the children of a task accessing a region
+	//!
+	//! \param[in] task is the Task that performs the taskwait
+	//! \param[in] address is the starting address of the region
+	//! \param[in] length is the length of the region
+	//! \param[in] accessType is READ_ACCESS_TYPE to wait for the writers, or READWRITE_ACCESS_TYPE to wait for all
+	//! \param[in] hpDependencyData is the CPUDependencyData used for delayed operations
+	//!
+	//! \returns true if the fragment is already satisfied, otherwise the task must pause and will
+	//! be resubmitted when the fragment is completed
+	bool registerTaskwaitFragment(
+		TaskMetadata *task,
+		void *address,
+		size_t length,
+		DataAccessType accessType,
+		CPUDependencyData &hpDependencyData);
+
 	//! \brief Mark a Taskwait fragment as completed
 	//!
 	//! \param[in] task is the Task that created the taskwait fragment
@@ -70,7 +109,6 @@ namespace DataAccessRegistration {
 	void releaseTaskwaitFragment(
 		TaskMetadata *task,
 		DataAccessRegion region,
-		size_t cpuId,
 		CPUDependencyData &hpDependencyData);
 
 	bool supportsDataTracking();
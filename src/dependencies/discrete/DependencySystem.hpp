@@ -9,21 +9,55 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 #include "CPUDependencyData.hpp"
+#include "ReductionKernels.hpp"
+#include "common/EnvironmentVariable.hpp"
+#include "common/ErrorHandler.hpp"
 #include "common/MathSupport.hpp"
 #include "hardware/HardwareInfo.hpp"
+#include "memory/ReductionBufferPool.hpp"
 
 
 class DependencySystem {
 
+	//! Maximum default number of originators kept before flushing them
+	static constexpr size_t DEFAULT_MAX_FLUSH_THRESHOLD = 256;
+
 public:
 
 	static void initialize()
 	{
-		size_t pow2CPUs = MathSupport::roundToNextPowOf2(HardwareInfo::getNumCpus());
-		TaskList::_actualChunkSize = std::min(TaskList::getMaxChunkSize(), pow2CPUs * 2);
-		assert(MathSupport::isPowOf2(TaskList::_actualChunkSize));
+		EnvironmentVariable<std::string> flushPolicy("NODES_DEPS_FLUSH_POLICY", "count");
+		EnvironmentVariable<size_t> flushThreshold("NODES_DEPS_FLUSH_THRESHOLD", 0);
+
+		// By default, flush the lists of originators after twice as many tasks as CPUs
+		size_t threshold = flushThreshold.getValue();
+		if (threshold == 0) {
+			size_t pow2CPUs = MathSupport::roundToNextPowOf2(HardwareInfo::getNumCpus());
+			threshold = std::min(DEFAULT_MAX_FLUSH_THRESHOLD, pow2CPUs * 2);
+		}
+		CPUDependencyData::_deletableFlushThreshold = threshold;
+
+		// The release policy submits the satisfied originators only once all the accesses
+		// have been released, so large fan-outs are submitted at once
+		if (flushPolicy.getValue() == "count") {
+			CPUDependencyData::_satisfiedFlushThreshold = threshold;
+		} else if (flushPolicy.getValue() == "release") {
+			CPUDependencyData::_satisfiedFlushThreshold = SIZE_MAX;
+		} else {
+			ErrorHandler::fail("Invalid value for NODES_DEPS_FLUSH_POLICY: ", flushPolicy.getValue(), ". Valid values are count and release");
+		}
+
+		ReductionKernels::initialize();
+		ReductionBufferPool::initialize();
+	}
+
+	static void shutdown()
+	{
+		ReductionBufferPool::shutdown();
 	}
 };
 
@@ -7,7 +7,6 @@
 #ifndef DEVICE_REDUCTION_STORAGE_HPP
 #define DEVICE_REDUCTION_STORAGE_HPP
 
-#include <functional>
 #include <queue>
 #include <unordered_map>
 #include <vector>
@@ -26,15 +25,15 @@ protected:
 	const size_t _length;
 	const size_t _paddedLength;
 
-	std::function<void(void *, void *, size_t)> _initializationFunction;
-	std::function<void(void *, void *, size_t)> _combinationFunction;
+	reduction_function_t _initializationFunction;
+	reduction_function_t _combinationFunction;
 
 public:
 
 	DeviceReductionStorage(
 		void *address, size_t length, size_t paddedLength,
-		std::function<void(void *, void *, size_t)> initializationFunction,
-		std::function<void(void *, void *, size_t)> combinationFunction) :
+		reduction_function_t initializationFunction,
+		reduction_function_t combinationFunction) :
 		_address(address),
 		_length(length),
 		_paddedLength(paddedLength),
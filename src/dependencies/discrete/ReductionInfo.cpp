@@ -11,6 +11,7 @@
 
 #include "DeviceReductionStorage.hpp"
 #include "ReductionInfo.hpp"
+#include "ReductionKernels.hpp"
 #include "common/Padding.hpp"
 #include "dependencies/discrete/devices/HostReductionStorage.hpp"
 #include "memory/MemoryAllocator.hpp"
@@ -18,14 +19,14 @@
 
 
 ReductionInfo::ReductionInfo(void *address, size_t length, reduction_type_and_operator_index_t typeAndOperatorIndex,
-	std::function<void(void *, void *, size_t)> initializationFunction, std::function<void(void *, void *, size_t)> combinationFunction,
+	reduction_function_t initializationFunction, reduction_function_t combinationFunction,
 	bool inTaskiter) :
 	_address(address),
 	_length(length),
 	_paddedLength(((length + CACHELINE_SIZE - 1) / CACHELINE_SIZE) * CACHELINE_SIZE),
 	_typeAndOperatorIndex(typeAndOperatorIndex),
-	_initializationFunction(initializationFunction),
-	_combinationFunction(combinationFunction),
+	_initializationFunction(ReductionKernels::getInitializer(typeAndOperatorIndex, initializationFunction)),
+	_combinationFunction(ReductionKernels::getCombiner(typeAndOperatorIndex, combinationFunction)),
 	_registeredAccesses(2),
 	_originalAccesses(0),
 	_inTaskiter(inTaskiter)
@@ -76,7 +77,9 @@ DeviceReductionStorage *ReductionInfo::allocateDeviceStorage(nanos6_device_t dev
 	switch (deviceType) {
 		case nanos6_host_device:
 			storage = new HostReductionStorage(_address, _length, _paddedLength,
-				_initializationFunction, _combinationFunction);
+				_initializationFunction, _combinationFunction,
+				ReductionKernels::getElementSize(_typeAndOperatorIndex),
+				ReductionKernels::hasZeroIdentity(_typeAndOperatorIndex));
 			break;
 		default:
 			break;
@@ -8,7 +8,6 @@
 #define REDUCTION_INFO_HPP
 
 #include <atomic>
-#include <functional>
 
 #include <nodes/task-instantiation.h>
 
@@ -41,8 +40,8 @@ private:
 
 	DeviceReductionStorage *_deviceStorages[nanos6_device_type_num];
 
-	std::function<void(void *, void *, size_t)> _initializationFunction;
-	std::function<void(void *, void *, size_t)> _combinationFunction;
+	reduction_function_t _initializationFunction;
+	reduction_function_t _combinationFunction;
 
 	std::atomic<size_t> _registeredAccesses;
 
@@ -58,8 +57,8 @@ private:
 public:
 
 	ReductionInfo(void *address, size_t length, reduction_type_and_operator_index_t typeAndOperatorIndex,
-		std::function<void(void *, void *, size_t)> initializationFunction,
-		std::function<void(void *, void *, size_t)> combinationFunction, bool inTaskiter);
+		reduction_function_t initializationFunction,
+		reduction_function_t combinationFunction, bool inTaskiter);
 
 	virtual ~ReductionInfo();
 
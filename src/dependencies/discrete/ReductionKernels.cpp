@@ -0,0 +1,201 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <complex>
+#include <cstddef>
+#include <limits>
+
+#include "ReductionKernels.hpp"
+
+
+ReductionKernels::kernels_t ReductionKernels::_kernels[ReductionKernels::NUM_TYPES][NUM_RED_OPS];
+EnvironmentVariable<bool> ReductionKernels::_enabled("NODES_REDUCTION_BUILTIN_KERNELS", true);
+
+namespace {
+
+	//! The identity and the combination of each operator
+	template <int OP>
+	struct Operator;
+
+	template <>
+	struct Operator<RED_OP_ADDITION> {
+		template <typename T> static inline T identity() { return T(0); }
+		template <typename T> static inline T combine(T a, T b) { return a + b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_PRODUCT> {
+		template <typename T> static inline T identity() { return T(1); }
+		template <typename T> static inline T combine(T a, T b) { return a * b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_BITWISE_AND> {
+		template <typename T> static inline T identity() { return (T) -1; }
+		template <typename T> static inline T combine(T a, T b) { return a & b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_BITWISE_OR> {
+		template <typename T> static inline T identity() { return T(0); }
+		template <typename T> static inline T combine(T a, T b) { return a | b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_BITWISE_XOR> {
+		template <typename T> static inline T identity() { return T(0); }
+		template <typename T> static inline T combine(T a, T b) { return a ^ b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_LOGICAL_AND> {
+		template <typename T> static inline T identity() { return T(1); }
+		template <typename T> static inline T combine(T a, T b) { return a && b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_LOGICAL_OR> {
+		template <typename T> static inline T identity() { return T(0); }
+		template <typename T> static inline T combine(T a, T b) { return a || b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_LOGICAL_XOR> {
+		template <typename T> static inline T identity() { return T(0); }
+		template <typename T> static inline T combine(T a, T b) { return (bool) a != (bool) b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_LOGICAL_NXOR> {
+		template <typename T> static inline T identity() { return T(1); }
+		template <typename T> static inline T combine(T a, T b) { return (bool) a == (bool) b; }
+	};
+
+	template <>
+	struct Operator<RED_OP_MAXIMUM> {
+		template <typename T> static inline T identity()
+		{
+			// Use infinity when available, so that it is the exact identity
+			if (std::numeric_limits<T>::has_infinity)
+				return -std::numeric_limits<T>::infinity();
+			return std::numeric_limits<T>::lowest();
+		}
+		template <typename T> static inline T combine(T a, T b) { return (b > a) ? b : a; }
+	};
+
+	template <>
+	struct Operator<RED_OP_MINIMUM> {
+		template <typename T> static inline T identity()
+		{
+			if (std::numeric_limits<T>::has_infinity)
+				return std::numeric_limits<T>::infinity();
+			return std::numeric_limits<T>::max();
+		}
+		template <typename T> static inline T combine(T a, T b) { return (b < a) ? b : a; }
+	};
+
+	template <typename T, int OP>
+	void initialize(void *priv, void *, size_t size)
+	{
+		T *__restrict__ out = (T *) priv;
+		const size_t count = size / sizeof(T);
+		const T identity = Operator<OP>::template identity<T>();
+
+		for (size_t i = 0; i < count; ++i)
+			out[i] = identity;
+	}
+
+	template <typename T, int OP>
+	void combine(void *orig, void *priv, size_t size)
+	{
+		T *__restrict__ out = (T *) orig;
+		const T *__restrict__ in = (const T *) priv;
+		const size_t count = size / sizeof(T);
+
+		for (size_t i = 0; i < count; ++i)
+			out[i] = Operator<OP>::combine(out[i], in[i]);
+	}
+
+	template <typename T, int OP>
+	inline void registerKernels(ReductionKernels::kernels_t (&kernels)[NUM_RED_OPS])
+	{
+		kernels[OP]._initializer = initialize<T, OP>;
+		kernels[OP]._combiner = combine<T, OP>;
+		kernels[OP]._elementSize = sizeof(T);
+		kernels[OP]._zeroIdentity = (Operator<OP>::template identity<T>() == T());
+	}
+
+	//! Operators that are valid for any real type
+	template <typename T>
+	inline void registerRealType(ReductionKernels::kernels_t (&kernels)[NUM_RED_OPS])
+	{
+		registerKernels<T, RED_OP_ADDITION>(kernels);
+		registerKernels<T, RED_OP_PRODUCT>(kernels);
+		registerKernels<T, RED_OP_LOGICAL_AND>(kernels);
+		registerKernels<T, RED_OP_LOGICAL_OR>(kernels);
+		registerKernels<T, RED_OP_LOGICAL_XOR>(kernels);
+		registerKernels<T, RED_OP_LOGICAL_NXOR>(kernels);
+		registerKernels<T, RED_OP_MAXIMUM>(kernels);
+		registerKernels<T, RED_OP_MINIMUM>(kernels);
+	}
+
+	template <typename T>
+	inline void registerIntegralType(ReductionKernels::kernels_t (&kernels)[NUM_RED_OPS])
+	{
+		registerRealType<T>(kernels);
+		registerKernels<T, RED_OP_BITWISE_AND>(kernels);
+		registerKernels<T, RED_OP_BITWISE_OR>(kernels);
+		registerKernels<T, RED_OP_BITWISE_XOR>(kernels);
+	}
+
+	//! Booleans do not support the arithmetic operators in the runtime, since the compiler
+	//! would promote them to integers
+	inline void registerBooleanType(ReductionKernels::kernels_t (&kernels)[NUM_RED_OPS])
+	{
+		registerKernels<bool, RED_OP_BITWISE_AND>(kernels);
+		registerKernels<bool, RED_OP_BITWISE_OR>(kernels);
+		registerKernels<bool, RED_OP_BITWISE_XOR>(kernels);
+		registerKernels<bool, RED_OP_LOGICAL_AND>(kernels);
+		registerKernels<bool, RED_OP_LOGICAL_OR>(kernels);
+		registerKernels<bool, RED_OP_LOGICAL_XOR>(kernels);
+		registerKernels<bool, RED_OP_LOGICAL_NXOR>(kernels);
+		registerKernels<bool, RED_OP_MAXIMUM>(kernels);
+		registerKernels<bool, RED_OP_MINIMUM>(kernels);
+	}
+
+	//! Complex numbers only support the arithmetic operators. The C complex types have the
+	//! same layout as their std::complex counterparts
+	template <typename T>
+	inline void registerComplexType(ReductionKernels::kernels_t (&kernels)[NUM_RED_OPS])
+	{
+		registerKernels<std::complex<T>, RED_OP_ADDITION>(kernels);
+		registerKernels<std::complex<T>, RED_OP_PRODUCT>(kernels);
+	}
+}
+
+void ReductionKernels::initialize()
+{
+	kernels_t (&table)[NUM_TYPES][NUM_RED_OPS] = _kernels;
+
+	registerIntegralType<char>(table[RED_TYPE_CHAR / RED_TYPE_CHAR]);
+	registerIntegralType<signed char>(table[RED_TYPE_SIGNED_CHAR / RED_TYPE_CHAR]);
+	registerIntegralType<unsigned char>(table[RED_TYPE_UNSIGNED_CHAR / RED_TYPE_CHAR]);
+	registerIntegralType<short>(table[RED_TYPE_SHORT / RED_TYPE_CHAR]);
+	registerIntegralType<unsigned short>(table[RED_TYPE_UNSIGNED_SHORT / RED_TYPE_CHAR]);
+	registerIntegralType<int>(table[RED_TYPE_INT / RED_TYPE_CHAR]);
+	registerIntegralType<unsigned int>(table[RED_TYPE_UNSIGNED_INT / RED_TYPE_CHAR]);
+	registerIntegralType<long>(table[RED_TYPE_LONG / RED_TYPE_CHAR]);
+	registerIntegralType<unsigned long>(table[RED_TYPE_UNSIGNED_LONG / RED_TYPE_CHAR]);
+	registerIntegralType<long long>(table[RED_TYPE_LONG_LONG / RED_TYPE_CHAR]);
+	registerIntegralType<unsigned long long>(table[RED_TYPE_UNSIGNED_LONG_LONG / RED_TYPE_CHAR]);
+	registerRealType<float>(table[RED_TYPE_FLOAT / RED_TYPE_CHAR]);
+	registerRealType<double>(table[RED_TYPE_DOUBLE / RED_TYPE_CHAR]);
+	registerRealType<long double>(table[RED_TYPE_LONG_DOUBLE / RED_TYPE_CHAR]);
+	registerComplexType<float>(table[RED_TYPE_COMPLEX_FLOAT / RED_TYPE_CHAR]);
+	registerComplexType<double>(table[RED_TYPE_COMPLEX_DOUBLE / RED_TYPE_CHAR]);
+	registerComplexType<long double>(table[RED_TYPE_COMPLEX_LONG_DOUBLE / RED_TYPE_CHAR]);
+	registerBooleanType(table[RED_TYPE_BOOLEAN / RED_TYPE_CHAR]);
+}
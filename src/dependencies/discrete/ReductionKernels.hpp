@@ -0,0 +1,117 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef REDUCTION_KERNELS_HPP
+#define REDUCTION_KERNELS_HPP
+
+#include <nodes/reductions.h>
+
+#include "ReductionSpecific.hpp"
+#include "common/EnvironmentVariable.hpp"
+
+
+//! Built-in initialization and combination kernels for the reductions over arithmetic
+//! types, which the runtime uses instead of the compiler-generated functions whenever the
+//! type and the operator are known. They are written to be vectorized by the compiler
+class ReductionKernels {
+
+public:
+
+	struct kernels_t {
+		reduction_function_t _initializer;
+		reduction_function_t _combiner;
+		size_t _elementSize;
+
+		//! Whether the identity is represented by zero bytes
+		bool _zeroIdentity;
+	};
+
+	static constexpr int NUM_TYPES = NUM_RED_TYPES / RED_TYPE_CHAR;
+
+private:
+
+	//! Kernels indexed by type and operator, which are null for unsupported pairs
+	static kernels_t _kernels[NUM_TYPES][NUM_RED_OPS];
+
+	//! Whether the built-in kernels are used at all
+	static EnvironmentVariable<bool> _enabled;
+
+	static inline const kernels_t *getKernels(reduction_type_and_operator_index_t typeAndOperatorIndex)
+	{
+		if (typeAndOperatorIndex < RED_TYPE_CHAR || typeAndOperatorIndex >= NUM_RED_TYPES)
+			return nullptr;
+
+		int type = typeAndOperatorIndex / RED_TYPE_CHAR;
+		int op = typeAndOperatorIndex % RED_TYPE_CHAR;
+		if (op >= NUM_RED_OPS)
+			return nullptr;
+
+		const kernels_t *kernels = &_kernels[type][op];
+		if (kernels->_initializer == nullptr || !_enabled.getValue())
+			return nullptr;
+
+		return kernels;
+	}
+
+public:
+
+	//! \brief Fill the table of kernels
+	static void initialize();
+
+	//! \brief Get the initializer of a reduction
+	//!
+	//! \param[in] typeAndOperatorIndex The type and operator of the reduction
+	//! \param[in] fallback The initializer provided by the compiler
+	//!
+	//! \returns The built-in initializer if there is one, or the fallback otherwise
+	static inline reduction_function_t getInitializer(
+		reduction_type_and_operator_index_t typeAndOperatorIndex,
+		reduction_function_t fallback
+	) {
+		const kernels_t *kernels = getKernels(typeAndOperatorIndex);
+		return (kernels != nullptr) ? kernels->_initializer : fallback;
+	}
+
+	//! \brief Get the size of the elements of a reduction
+	//!
+	//! \param[in] typeAndOperatorIndex The type and operator of the reduction
+	//!
+	//! \returns The size of the elements if the reduction uses the built-in kernels, or 0
+	//! if the layout of the data is unknown to the runtime
+	static inline size_t getElementSize(reduction_type_and_operator_index_t typeAndOperatorIndex)
+	{
+		const kernels_t *kernels = getKernels(typeAndOperatorIndex);
+		return (kernels != nullptr) ? kernels->_elementSize : 0;
+	}
+
+	//! \brief Check whether the private copies of a reduction can start as zero bytes
+	//!
+	//! \param[in] typeAndOperatorIndex The type and operator of the reduction
+	//!
+	//! \returns True if the reduction uses the built-in kernels and its identity is zero,
+	//! so memory that was never written already holds the identity
+	static inline bool hasZeroIdentity(reduction_type_and_operator_index_t typeAndOperatorIndex)
+	{
+		const kernels_t *kernels = getKernels(typeAndOperatorIndex);
+		return (kernels != nullptr) ? kernels->_zeroIdentity : false;
+	}
+
+	//! \brief Get the combiner of a reduction
+	//!
+	//! \param[in] typeAndOperatorIndex The type and operator of the reduction
+	//! \param[in] fallback The combiner provided by the compiler
+	//!
+	//! \returns The built-in combiner if there is one, or the fallback otherwise
+	static inline reduction_function_t getCombiner(
+		reduction_type_and_operator_index_t typeAndOperatorIndex,
+		reduction_function_t fallback
+	) {
+		const kernels_t *kernels = getKernels(typeAndOperatorIndex);
+		return (kernels != nullptr) ? kernels->_combiner : fallback;
+	}
+};
+
+#endif // REDUCTION_KERNELS_HPP
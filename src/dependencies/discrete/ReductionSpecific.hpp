@@ -7,12 +7,16 @@
 #ifndef REDUCTION_SPECIFIC_HPP
 #define REDUCTION_SPECIFIC_HPP
 
+#include <cstddef>
 #include <limits.h>
 
 
 typedef int reduction_type_and_operator_index_t;
 typedef int reduction_index_t;
 
+//! Signature of the initializers and combiners of reductions
+typedef void (*reduction_function_t)(void *, void *, size_t);
+
 enum specialReductionTypeAndOperatorIndexes_t {
 	no_reduction_type_and_operator = INT_MAX
 };
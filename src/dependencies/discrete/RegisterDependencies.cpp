@@ -14,6 +14,7 @@
 #include "ReductionSpecific.hpp"
 #include "dependencies/DataAccessType.hpp"
 #include "tasks/TaskMetadata.hpp"
+#include "tasks/TaskloopMetadata.hpp"
 
 
 template <DataAccessType ACCESS_TYPE, bool WEAK>
@@ -28,7 +29,14 @@ void register_access(void *handler, void *start, size_t length, int symbolIndex,
 		return;
 	}
 
-	bool weak = (WEAK && !task->isFinal()) || task->isTaskloopSource();
+	// Self-scheduled executors do not register accesses, so the tasks nested in their chunks
+	// could not be linked to a weak access of the source. Such taskloops use the static
+	// schedule instead, and the accesses registered before this one simply stay strong
+	if (WEAK && !task->isFinal() && task->isSelfSchedulingSource())
+		((TaskloopMetadata *) task)->disableSelfScheduling();
+
+	// Self-scheduled executors do not register accesses, so their source must be strong
+	bool weak = !task->isSelfSchedulingSource() && ((WEAK && !task->isFinal()) || task->isTaskloopSource());
 	DataAccessRegistration::registerTaskDataAccess(task, ACCESS_TYPE, weak, start,
 		length, reductionTypeAndOperatorIndex, reductionIndex, symbolIndex);
 }
@@ -10,7 +10,7 @@
 #include <nodes/multidimensional-release.h>
 
 #include "DataAccessRegistration.hpp"
-#include "hardware/HardwareInfo.hpp"
+#include "hardware/CPUContext.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
@@ -20,17 +20,27 @@ void release_access(void *base_address, __attribute__((unused)) long dim1size, l
 	TaskMetadata *task = TaskMetadata::getCurrentTask();
 	assert(task != nullptr);
 
-	int cpuId = nosv_get_current_logical_cpu();
-	if (cpuId < 0) {
-		ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
-	}
-
-	CPUDependencyData *cpuDepData = HardwareInfo::getCPUDependencyData(cpuId);
+	size_t cpuId = CPUContext::getCpuId();
+	CPUDependencyData *cpuDepData = CPUContext::getDependencyData();
 	void *effectiveAddress = static_cast<char *>(base_address) + dim1start;
 
 	DataAccessRegistration::releaseAccessRegion(task, effectiveAddress, ACCESS_TYPE, WEAK, cpuId, *cpuDepData);
 }
 
+void nanos6_release_symbol(int symbol_index)
+{
+	TaskMetadata *task = TaskMetadata::getCurrentTask();
+	assert(task != nullptr);
+
+	ErrorHandler::failIf(symbol_index < 0 || symbol_index >= (int) DataAccess::MAX_SYMBOLS,
+		"Invalid symbol index ", symbol_index, " in nanos6_release_symbol");
+
+	size_t cpuId = CPUContext::getCpuId();
+	CPUDependencyData *cpuDepData = CPUContext::getDependencyData();
+
+	DataAccessRegistration::releaseSymbolAccesses(task, symbol_index, cpuId, *cpuDepData);
+}
+
 void nanos6_release_read_1(void *base_address, long dim1size, long dim1start, long dim1end)
 {
 	release_access<READ_ACCESS_TYPE, false>(base_address, dim1size, dim1start, dim1end);
@@ -13,8 +13,8 @@
 class TaskiterReductionInfo : public ReductionInfo, public TaskiterNode {
     public:
     inline TaskiterReductionInfo(void *address, size_t length, reduction_type_and_operator_index_t typeAndOperatorIndex,
-		std::function<void(void *, void *, size_t)> initializationFunction,
-		std::function<void(void *, void *, size_t)> combinationFunction, bool inTaskiter_) :
+		reduction_function_t initializationFunction,
+		reduction_function_t combinationFunction, bool inTaskiter_) :
         ReductionInfo(address, length, typeAndOperatorIndex, initializationFunction, combinationFunction, inTaskiter_),
         TaskiterNode(nullptr, (ReductionInfo *) this)
     {
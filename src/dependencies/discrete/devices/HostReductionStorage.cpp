@@ -4,41 +4,92 @@
 	Copyright (C) 2021 Barcelona Supercomputing Center (BSC)
 */
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <nosv.h>
 
 #include "HostReductionStorage.hpp"
+#include "common/ErrorHandler.hpp"
+#include "common/Padding.hpp"
+#include "common/SpinWait.hpp"
+#include "hardware/CPUContext.hpp"
 #include "hardware/HardwareInfo.hpp"
-#include "memory/MemoryAllocator.hpp"
+#include "instrument/Statistics.hpp"
+#include "memory/ReductionBufferPool.hpp"
+#include "system/SpawnFunction.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
+EnvironmentVariable<size_t> HostReductionStorage::_parallelCombineThreshold("NODES_REDUCTION_PARALLEL_COMBINE_THRESHOLD", 4 * 1024 * 1024);
+EnvironmentVariable<size_t> HostReductionStorage::_parallelCombineChunkSize("NODES_REDUCTION_PARALLEL_COMBINE_CHUNK", 256 * 1024);
+EnvironmentVariable<bool> HostReductionStorage::_lazyPrivatization("NODES_REDUCTION_LAZY_PRIVATIZATION", false);
+EnvironmentVariable<size_t> HostReductionStorage::_lazyPrivatizationThreshold("NODES_REDUCTION_LAZY_THRESHOLD", 1024 * 1024);
+const size_t HostReductionStorage::_pageSize = sysconf(_SC_PAGESIZE);
+
+struct ReductionCombineHelperArgs {
+	void *_state;
+};
+
 HostReductionStorage::HostReductionStorage(void *address, size_t length, size_t paddedLength,
-	std::function<void(void *, void *, size_t)> initializationFunction,
-	std::function<void(void *, void *, size_t)> combinationFunction) :
+	reduction_function_t initializationFunction,
+	reduction_function_t combinationFunction,
+	size_t elementSize,
+	bool zeroIdentity) :
 	DeviceReductionStorage(address, length, paddedLength, initializationFunction, combinationFunction),
-	_freeSlotIndices(HardwareInfo::getNumCpus())
+	_elementSize(elementSize),
+	_lazy(false),
+	_lazyLength(0),
+	_slots(HardwareInfo::getNumCpus())
 {
-	const long nCpus = HardwareInfo::getNumCpus();
-	assert(nCpus > 0);
+	assert(!_slots.empty());
 
-	// Create all slots
-	_slots.resize(nCpus);
-	_currentCpuSlotIndices.resize(nCpus, -1);
+	// Private copies that start as zero bytes can be mapped without touching them, as long
+	// as the elements do not straddle the pages that are combined separately
+	if (_lazyPrivatization.getValue() && zeroIdentity && length >= _lazyPrivatizationThreshold.getValue()
+		&& elementSize > 0 && (_pageSize % elementSize) == 0
+	) {
+		_lazy = true;
+		_lazyLength = ((paddedLength + _pageSize - 1) / _pageSize) * _pageSize;
+	}
+}
+
+HostReductionStorage::~HostReductionStorage()
+{
+	for (slot_t *slot : _fallbackSlots) {
+		assert(slot->owner.load(std::memory_order_relaxed) == nullptr);
+		assert(!slot->initialized);
+		delete slot;
+	}
 }
 
 void *HostReductionStorage::getFreeSlotStorage(__attribute__((unused)) TaskMetadata *task, size_t slotIndex, size_t)
 {
 	assert(task != nullptr);
-	assert(slotIndex < _slots.size());
-
-	slot_t &slot = _slots[slotIndex];
+	slot_t &slot = getSlot(slotIndex);
+	assert(slot.owner.load(std::memory_order_relaxed) == task);
 	assert(slot.initialized || slot.storage == nullptr);
 
-	if (!slot.initialized) {
-		// Allocate new storage
-		slot.storage = MemoryAllocator::alloc(_paddedLength);
+	if (!slot.initialized)
+		Statistics::increment(Statistics::REDUCTION_SLOT_ALLOCATIONS);
+
+	if (!slot.initialized && _lazy) {
+		// Pages are zero-filled and first touched by the CPU that writes them
+		slot.storage = mmap(nullptr, _lazyLength, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		ErrorHandler::failIf(slot.storage == MAP_FAILED, "Failed to map the storage of a reduction");
+
+		// Keep the dirty pages small, a huge page would be combined as a whole
+		madvise(slot.storage, _lazyLength, MADV_NOHUGEPAGE);
+		slot.initialized = true;
+	} else if (!slot.initialized) {
+		// Borrow storage that is local to this CPU, which the initialization touches first
+		slot.numaNode = CPUContext::getNumaNode();
+		slot.storage = ReductionBufferPool::allocate(_paddedLength, slot.numaNode);
 		_initializationFunction(slot.storage, _address, _length);
 		slot.initialized = true;
 	}
@@ -52,59 +103,265 @@ void HostReductionStorage::combineInStorage(void *combineDestination)
 
 	// Ensure we see writes from other threads that affected the slots
 	std::atomic_thread_fence(std::memory_order_acquire);
-	for (size_t i = 0; i < _slots.size(); ++i) {
-		slot_t &slot = _slots[i];
 
-		if (slot.initialized) {
-			assert(slot.storage != nullptr);
-			assert(slot.storage != combineDestination);
+	// Nobody can acquire slots at this point, so the fallback slots can be accessed directly
+	std::vector<slot_t *> slots;
+	slots.reserve(_slots.size() + _fallbackSlots.size());
+	for (slot_t &slot : _slots)
+		slots.push_back(&slot);
+	slots.insert(slots.end(), _fallbackSlots.begin(), _fallbackSlots.end());
+
+	// Large reductions are split in chunks that can be combined in parallel, as long as
+	// the elements are known not to straddle the chunks
+	const size_t threshold = _parallelCombineThreshold.getValue();
+	if (threshold > 0 && _length >= threshold && _elementSize > 0 && (CACHELINE_SIZE % _elementSize) == 0) {
+		std::vector<char *> sources;
+		std::vector<std::vector<unsigned char>> dirtyPages;
+		for (slot_t *slot : slots) {
+			if (slot->initialized) {
+				assert(slot->storage != nullptr);
+				assert(slot->storage != combineDestination);
+				sources.push_back((char *) slot->storage);
+				dirtyPages.emplace_back();
+				getDirtyPages(*slot, dirtyPages.back());
+			}
+		}
+
+		if (sources.size() > 1) {
+			combineInParallel((char *) combineDestination, sources, dirtyPages);
+		} else if (sources.size() == 1) {
+			combineSparse(_combinationFunction, (char *) combineDestination,
+				sources[0], dirtyPages[0], 0, _length);
+		}
+	} else {
+		std::vector<unsigned char> dirtyPages;
+		for (slot_t *slot : slots) {
+			if (slot->initialized) {
+				assert(slot->storage != nullptr);
+				assert(slot->storage != combineDestination);
+
+				getDirtyPages(*slot, dirtyPages);
+				combineSparse(_combinationFunction, (char *) combineDestination,
+					(const char *) slot->storage, dirtyPages, 0, _length);
+			}
+		}
+	}
+
+	for (slot_t *slot : slots) {
+		assert(slot->owner.load(std::memory_order_relaxed) == nullptr);
+
+		if (slot->initialized && _lazy) {
+			munmap(slot->storage, _lazyLength);
+			slot->storage = nullptr;
+			slot->initialized = false;
+		} else if (slot->initialized) {
+			ReductionBufferPool::release(slot->storage, _paddedLength, slot->numaNode);
+			slot->storage = nullptr;
+			slot->initialized = false;
+		}
+	}
+}
+
+void HostReductionStorage::getDirtyPages(const slot_t &slot, std::vector<unsigned char> &dirtyPages) const
+{
+	dirtyPages.clear();
+	if (!_lazy)
+		return;
+
+	// A page that has been written is either present or swapped out, since private anonymous
+	// pages cannot be dropped. Residency alone is not enough, as written pages may have been
+	// swapped out. Pages that were only read are backed by the zero page and may appear as
+	// present too, which is harmless
+	const size_t numPages = _lazyLength / _pageSize;
+	std::vector<uint64_t> entries(numPages);
+
+	int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
 
-			_combinationFunction(combineDestination, slot.storage, _length);
+	const off_t offset = (off_t) (((uintptr_t) slot.storage / _pageSize) * sizeof(uint64_t));
+	const size_t bytes = numPages * sizeof(uint64_t);
+	ssize_t result = pread(fd, entries.data(), bytes, offset);
+	close(fd);
 
-			MemoryAllocator::free(slot.storage, _paddedLength);
-			slot.storage = nullptr;
-			slot.initialized = false;
+	// Combine the whole storage if the state of the pages is unknown
+	if (result != (ssize_t) bytes)
+		return;
+
+	dirtyPages.resize(numPages);
+	for (size_t p = 0; p < numPages; ++p)
+		dirtyPages[p] = ((entries[p] & (PAGEMAP_PRESENT | PAGEMAP_SWAPPED)) != 0);
+}
+
+void HostReductionStorage::combineSparse(
+	reduction_function_t combinationFunction,
+	char *destination, const char *source,
+	const std::vector<unsigned char> &dirtyPages,
+	size_t offset, size_t length
+) {
+	if (dirtyPages.empty()) {
+		combinationFunction(destination + offset, (void *) (source + offset), length);
+		return;
+	}
+
+	// Combine the runs of consecutive dirty pages at once
+	const size_t end = offset + length;
+	while (offset < end) {
+		size_t runEnd = std::min((offset / _pageSize + 1) * _pageSize, end);
+
+		if (dirtyPages[offset / _pageSize] & 1) {
+			while (runEnd < end && (dirtyPages[runEnd / _pageSize] & 1))
+				runEnd = std::min(runEnd + _pageSize, end);
+
+			combinationFunction(destination + offset, (void *) (source + offset), runEnd - offset);
 		}
+		offset = runEnd;
+	}
+}
+
+void HostReductionStorage::combineInParallel(char *destination, std::vector<char *> &sources,
+	std::vector<std::vector<unsigned char>> &dirtyPages)
+{
+	// Keep the chunks aligned to cache lines, which also keeps them aligned to the elements
+	size_t chunkSize = _parallelCombineChunkSize.getValue();
+	chunkSize = std::max((chunkSize / CACHELINE_SIZE) * CACHELINE_SIZE, (size_t) CACHELINE_SIZE);
+
+	const size_t numChunks = (_length + chunkSize - 1) / chunkSize;
+	const size_t numHelpers = std::min(HardwareInfo::getNumCpus(), numChunks) - 1;
+
+	ParallelCombine *state = new ParallelCombine();
+	state->_destination = destination;
+	state->_sources.swap(sources);
+	state->_dirtyPages.swap(dirtyPages);
+	state->_combinationFunction = _combinationFunction;
+	state->_length = _length;
+	state->_chunkSize = chunkSize;
+	state->_numChunks = numChunks;
+	state->_nextChunk.store(0, std::memory_order_relaxed);
+	state->_pendingChunks.store(numChunks, std::memory_order_relaxed);
+	state->_references.store(numHelpers + 1, std::memory_order_release);
+
+	// The helpers are regular tasks, so they may start late or not at all before the
+	// calling thread has combined every chunk. In that case they find no work left.
+	// They are spawned as if from user code only so that they are counted as pending
+	// spawned functions, which makes the shutdown wait for the helpers that still hold
+	// a reference to the combination state
+	for (size_t h = 0; h < numHelpers; ++h) {
+		ReductionCombineHelperArgs args = { state };
+		SpawnFunction::spawnFunction(
+			HostReductionStorage::combineHelperBody, nullptr,
+			std::move(args), "Reduction combination", /* fromUserCode */ true
+		);
 	}
+
+	combineChunks(state);
+
+	// Wait for the chunks that other threads are still combining
+	while (state->_pendingChunks.load(std::memory_order_acquire) > 0)
+		spinWait();
+	spinWaitRelease();
+
+	releaseParallelCombine(state);
 }
 
-size_t HostReductionStorage::getFreeSlotIndex(TaskMetadata *, size_t cpuId)
+void HostReductionStorage::combineChunks(ParallelCombine *state)
 {
-	assert((size_t) cpuId < _currentCpuSlotIndices.size());
-	long int currentSlotIndex = _currentCpuSlotIndices[cpuId];
-
-	if (currentSlotIndex != -1) {
-		// Storage already assigned to this CPU
-		// Note: Currently, this can only happen with a weakreduction task with
-		// 2 or more (in_final) reduction subtasks that will be requesting storage
-		// Note: Task scheduling points within reduction are currently not supported,
-		// as tied tasks are not yet implemented. If supported, task counters would be
-		// required to avoid the storage to be released at the end of a task while still in use
-
-		assert(_slots[currentSlotIndex].initialized);
-		return currentSlotIndex;
+	size_t chunk;
+	while ((chunk = state->_nextChunk.fetch_add(1, std::memory_order_relaxed)) < state->_numChunks) {
+		const size_t offset = chunk * state->_chunkSize;
+		const size_t length = std::min(state->_chunkSize, state->_length - offset);
+
+		// Combine every slot on the same chunk while the destination is in cache
+		for (size_t s = 0; s < state->_sources.size(); ++s) {
+			combineSparse(state->_combinationFunction, state->_destination,
+				state->_sources[s], state->_dirtyPages[s], offset, length);
+		}
+
+		state->_pendingChunks.fetch_sub(1, std::memory_order_release);
 	}
+}
+
+void HostReductionStorage::combineHelperBody(void *args)
+{
+	ParallelCombine *state = (ParallelCombine *) ((ReductionCombineHelperArgs *) args)->_state;
+	assert(state != nullptr);
+
+	combineChunks(state);
+	releaseParallelCombine(state);
+}
+
+size_t HostReductionStorage::getFreeSlotIndex(TaskMetadata *task, size_t cpuId)
+{
+	assert(task != nullptr);
+	assert(cpuId < _slots.size());
+
+	// Normally only the tasks running on this CPU acquire its slot, so the exchange is not
+	// contended. It still protects the slot if the CPU of the caller is not accurate. The
+	// slot keeps its storage from previous tasks, which accumulate on the same copy
+	slot_t &slot = _slots[cpuId];
+	TaskMetadata *owner = slot.owner.load(std::memory_order_acquire);
+	if (owner == task)
+		return cpuId;
+
+	if (owner == nullptr && slot.owner.compare_exchange_strong(owner, task, std::memory_order_acquire))
+		return cpuId;
+
+	// The slot is held by a task that blocked in the middle of its reduction, and which
+	// may be resumed on any CPU, or by an ancestor task running a nested reduction task
+	return getFallbackSlotIndex(task);
+}
 
-	int freeSlotIndex = _freeSlotIndices.setFirst();
-	while (freeSlotIndex == -1)
-		freeSlotIndex = _freeSlotIndices.setFirst();
+size_t HostReductionStorage::getFallbackSlotIndex(TaskMetadata *task)
+{
+	Statistics::increment(Statistics::REDUCTION_SLOT_FALLBACKS);
+
+	std::lock_guard<PaddedSpinLock<>> guard(_fallbackLock);
+
+	for (size_t i = 0; i < _fallbackSlots.size(); ++i) {
+		slot_t *slot = _fallbackSlots[i];
+		if (slot->owner.load(std::memory_order_acquire) == nullptr) {
+			slot->owner.store(task, std::memory_order_relaxed);
+			return _slots.size() + i;
+		}
+	}
 
-	_currentCpuSlotIndices[cpuId] = freeSlotIndex;
+	slot_t *slot = new slot_t();
+	slot->owner.store(task, std::memory_order_relaxed);
+	_fallbackSlots.push_back(slot);
 
-	return freeSlotIndex;
+	return _slots.size() + _fallbackSlots.size() - 1;
 }
 
-void HostReductionStorage::releaseSlotsInUse(TaskMetadata *, size_t cpuId)
+void HostReductionStorage::releaseSlotsInUse(TaskMetadata *task, size_t cpuId)
 {
-	assert(cpuId < _currentCpuSlotIndices.size());
-	long int currentSlotIndex = _currentCpuSlotIndices[cpuId];
-
-	// Note: If access is weak and final (promoted), but had no reduction subtasks, this
-	// member can be called when _currentCpuSlotIndices[task] is invalid (hasn't been used)
-	if (currentSlotIndex != -1) {
-		assert(_slots[currentSlotIndex].storage != nullptr);
-		assert(_slots[currentSlotIndex].initialized);
-		_freeSlotIndices.reset(currentSlotIndex);
-		_currentCpuSlotIndices[cpuId] = -1;
+	assert(task != nullptr);
+	assert(cpuId < _slots.size());
+
+	// Common case: the task acquired the slot of the CPU where it finishes. A task acquires
+	// a single slot per reduction, since its addresses are translated once
+	slot_t &slot = _slots[cpuId];
+	if (slot.owner.load(std::memory_order_relaxed) == task) {
+		assert(slot.initialized);
+		slot.owner.store(nullptr, std::memory_order_release);
+		return;
+	}
+
+	// The task migrated after acquiring a slot, used a fallback slot, or never acquired one
+	// (i.e., a weak access promoted by a final task without reduction subtasks)
+	for (slot_t &other : _slots) {
+		if (other.owner.load(std::memory_order_relaxed) == task) {
+			assert(other.initialized);
+			other.owner.store(nullptr, std::memory_order_release);
+			return;
+		}
+	}
+
+	std::lock_guard<PaddedSpinLock<>> guard(_fallbackLock);
+	for (slot_t *other : _fallbackSlots) {
+		if (other->owner.load(std::memory_order_relaxed) == task) {
+			assert(other->initialized);
+			other->owner.store(nullptr, std::memory_order_release);
+			return;
+		}
 	}
 }
@@ -7,7 +7,11 @@
 #ifndef HOST_REDUCTION_STORAGE_HPP
 #define HOST_REDUCTION_STORAGE_HPP
 
-#include "common/AtomicBitset.hpp"
+#include <atomic>
+#include <cstdint>
+
+#include "common/EnvironmentVariable.hpp"
+#include "common/PaddedSpinLock.hpp"
 #include "dependencies/discrete/DeviceReductionStorage.hpp"
 #include "tasks/TaskMetadata.hpp"
 
@@ -19,13 +23,26 @@ public:
 	struct ReductionSlot {
 		void *storage = nullptr;
 		bool initialized = false;
+
+		//! The NUMA node of the pool where the storage comes from
+		size_t numaNode = 0;
+
+		//! The task that is currently using the slot, or null if free
+		std::atomic<TaskMetadata *> owner;
+
+		ReductionSlot() :
+			owner(nullptr)
+		{
+		}
 	};
 
 	typedef ReductionSlot slot_t;
 
 	HostReductionStorage(void *address, size_t length, size_t paddedLength,
-		std::function<void(void *, void *, size_t)> initializationFunction,
-		std::function<void(void *, void *, size_t)> combinationFunction);
+		reduction_function_t initializationFunction,
+		reduction_function_t combinationFunction,
+		size_t elementSize,
+		bool zeroIdentity = false);
 
 	void *getFreeSlotStorage(TaskMetadata *task, size_t slotIndex, size_t cpuId);
 
@@ -35,13 +52,117 @@ public:
 
 	size_t getFreeSlotIndex(TaskMetadata *task, size_t cpuId);
 
-	~HostReductionStorage(){};
+	~HostReductionStorage();
 
 private:
 
+	//! State shared by the threads that combine a reduction in parallel
+	struct ParallelCombine {
+		char *_destination;
+		std::vector<char *> _sources;
+
+		//! The pages touched in each source, or empty if the source is dense
+		std::vector<std::vector<unsigned char>> _dirtyPages;
+
+		reduction_function_t _combinationFunction;
+		size_t _length;
+		size_t _chunkSize;
+		size_t _numChunks;
+
+		//! The next chunk to be combined
+		std::atomic<size_t> _nextChunk;
+
+		//! The chunks that have not been combined yet
+		std::atomic<size_t> _pendingChunks;
+
+		//! The threads that may still access this state
+		std::atomic<size_t> _references;
+	};
+
+	//! Size of the elements of the reduction, or 0 if unknown
+	const size_t _elementSize;
+
+	//! Whether the slots are zero pages mapped on demand, which are only combined where
+	//! they were touched
+	bool _lazy;
+
+	//! Length of the private storage of the slots in lazy mode, rounded up to pages
+	size_t _lazyLength;
+
+	//! One slot per CPU, normally acquired only by the tasks running on that CPU
 	std::vector<slot_t> _slots;
-	std::vector<long int> _currentCpuSlotIndices;
-	AtomicBitset<> _freeSlotIndices;
+
+	//! Extra slots for the tasks that find the slot of their CPU in use. These are
+	//! allocated on demand and never move, so the pointers stay valid without the lock
+	std::vector<slot_t *> _fallbackSlots;
+	PaddedSpinLock<> _fallbackLock;
+
+	//! Whether large reductions with a zero identity are privatized lazily
+	static EnvironmentVariable<bool> _lazyPrivatization;
+
+	//! Minimum length in bytes of the reductions that are privatized lazily
+	static EnvironmentVariable<size_t> _lazyPrivatizationThreshold;
+
+	static const size_t _pageSize;
+
+	//! Bits of the entries of /proc/self/pagemap telling whether a page is present in memory
+	//! or swapped out
+	static constexpr uint64_t PAGEMAP_PRESENT = (1ULL << 63);
+	static constexpr uint64_t PAGEMAP_SWAPPED = (1ULL << 62);
+
+	//! Minimum length in bytes of the reductions that are combined in parallel, or 0 to
+	//! always combine them serially
+	static EnvironmentVariable<size_t> _parallelCombineThreshold;
+
+	//! Length in bytes of the parts of the data that are combined at once in parallel
+	static EnvironmentVariable<size_t> _parallelCombineChunkSize;
+
+	//! \brief Acquire one of the extra slots, or create a new one if all are in use
+	//!
+	//! These acquisitions are reported by the runtime statistics as reduction_slot_fallbacks
+	size_t getFallbackSlotIndex(TaskMetadata *task);
+
+	//! \brief Get a slot by its index, which may be a fallback slot
+	inline slot_t &getSlot(size_t slotIndex)
+	{
+		if (slotIndex < _slots.size())
+			return _slots[slotIndex];
+
+		std::lock_guard<PaddedSpinLock<>> guard(_fallbackLock);
+		assert(slotIndex - _slots.size() < _fallbackSlots.size());
+		return *_fallbackSlots[slotIndex - _slots.size()];
+	}
+
+	//! \brief Get the pages of a lazy slot that have been touched, which are the ones that are
+	//! present or swapped out. The result is empty if the whole slot must be combined
+	void getDirtyPages(const slot_t &slot, std::vector<unsigned char> &dirtyPages) const;
+
+	//! \brief Combine part of a source into the destination, skipping the pages that were
+	//! never touched if the source has dirty pages
+	static void combineSparse(
+		reduction_function_t combinationFunction,
+		char *destination, const char *source,
+		const std::vector<unsigned char> &dirtyPages,
+		size_t offset, size_t length);
+
+	//! \brief Combine all the slots into the destination splitting the data in chunks that
+	//! are combined by the calling thread and by spawned helpers
+	void combineInParallel(char *destination, std::vector<char *> &sources,
+		std::vector<std::vector<unsigned char>> &dirtyPages);
+
+	//! \brief Combine chunks until there are none left
+	static void combineChunks(ParallelCombine *state);
+
+	//! \brief Body of the spawned helpers of a parallel combination
+	static void combineHelperBody(void *args);
+
+	//! \brief Drop a reference to the state of a parallel combination, deleting it when
+	//! nobody else can access it
+	static inline void releaseParallelCombine(ParallelCombine *state)
+	{
+		if (state->_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete state;
+	}
 
 };
 
@@ -34,24 +34,24 @@ struct SpawnedLambdaArgsBlock {
 	std::function<void()> _function;
 	std::function<void()> _completionCallback;
 
-	SpawnedLambdaArgsBlock() :
-		_function(),
-		_completionCallback()
+	SpawnedLambdaArgsBlock(std::function<void()> &&function, std::function<void()> &&completionCallback) :
+		_function(std::move(function)),
+		_completionCallback(std::move(completionCallback))
 	{
 	}
 };
 
 static void spawnedLambdaWrapper(void *args)
 {
- 	SpawnedLambdaArgsBlock *block = (SpawnedLambdaArgsBlock *) args;
+	SpawnedLambdaArgsBlock *block = (SpawnedLambdaArgsBlock *) args;
 	block->_function();
 }
 
 static void spawnedLambdaCompletion(void *args)
 {
+	// The block lives inside the args block of the task and is destroyed by SpawnFunction
 	SpawnedLambdaArgsBlock *block = (SpawnedLambdaArgsBlock *) args;
 	block->_completionCallback();
-	delete block;
 }
 
 void TaskiterGraph::spawnLambda(
@@ -60,12 +60,11 @@ void TaskiterGraph::spawnLambda(
 	char const *label,
 	bool fromUserCode
 ) {
-	// This could be more efficient if we use the pre-allocated argsblock, but should do for now
-	SpawnedLambdaArgsBlock *args = new SpawnedLambdaArgsBlock();
-	args->_function = function;
-	args->_completionCallback = completionCallback;
-
-	SpawnFunction::spawnFunction(spawnedLambdaWrapper, (void *)args, spawnedLambdaCompletion, (void *)args, label, fromUserCode);
+	SpawnFunction::spawnFunction(
+		spawnedLambdaWrapper, spawnedLambdaCompletion,
+		SpawnedLambdaArgsBlock(std::move(function), std::move(completionCallback)),
+		label, fromUserCode
+	);
 }
 
 void TaskiterGraph::prioritizeCriticalPath()
@@ -75,20 +74,21 @@ void TaskiterGraph::prioritizeCriticalPath()
 	// Then, we will add time tracking and take that into account.
 
 	boost::property_map<graph_t, boost::vertex_name_t>::type nodemap = boost::get(boost::vertex_name_t(), _graphCpy);
-	std::unordered_map<graph_vertex_t, int> priorityMap;
+	std::unordered_map<graph_vertex_t, uint64_t> priorityMap;
 	std::vector<graph_vertex_t> reverseTopological;
 	graph_t::out_edge_iterator ei, eend;
 
 	boost::topological_sort(_graphCpy, std::back_inserter(reverseTopological));
 
+	uint64_t highestPriority = 0;
 	for (graph_vertex_t vertex : reverseTopological) {
-		int maxPriority = -1;
+		uint64_t maxPriority = 0;
 
 		for (boost::tie(ei, eend) = boost::out_edges(vertex, _graphCpy); ei != eend; ++ei) {
 			graph_t::edge_descriptor e = *ei;
 			graph_vertex_t to = boost::target(e, _graphCpy);
 
-			int successorPriority = priorityMap.at(to);
+			uint64_t successorPriority = priorityMap.at(to);
 			if (successorPriority > maxPriority)
 				maxPriority = successorPriority;
 		}
@@ -97,16 +97,25 @@ void TaskiterGraph::prioritizeCriticalPath()
 		TaskMetadata *task = node->getTask();
 
 		if (task) {
-			// This is adding uint64_t to the int maxPriority, which has a potential to overflow
-			// when iterations are very large
-			maxPriority += std::max(task->getElapsedTime(), 1UL);
-			assert(maxPriority >= 0);
-			task->setPriority(maxPriority);
+			maxPriority += std::max(task->getElapsedTime(), (uint64_t) 1);
 		} else {
 			maxPriority++;
 		}
 
 		priorityMap[vertex] = maxPriority;
+		highestPriority = std::max(highestPriority, maxPriority);
+	}
+
+	// Elapsed times are in nanoseconds, so scale the lengths of the paths down to fit
+	// in nOS-V priorities while keeping their order
+	unsigned int shift = 0;
+	while ((highestPriority >> shift) > (uint64_t) INT_MAX)
+		shift++;
+
+	for (graph_vertex_t vertex : reverseTopological) {
+		TaskMetadata *task = boost::get(nodemap, vertex)->getTask();
+		if (task)
+			task->setPriority((int) std::max(priorityMap[vertex] >> shift, (uint64_t) 1));
 	}
 }
 
@@ -1030,7 +1039,7 @@ static void graphTransformSequential(TaskiterGraph::graph_t &g, TaskMetadata *pa
 // 	end
 //   end
 
-static void graphTransformFront(TaskiterGraph::graph_t &g, TaskMetadata *parent, uint64_t us)
+static void graphTransformFront(TaskiterGraph::graph_t &g, TaskMetadata *parent, uint64_t ns)
 {
 	boost::property_map<TaskiterGraph::graph_t, boost::vertex_name_t>::type nodemap = boost::get(boost::vertex_name_t(), g);
 	TaskiterGraph::graph_t::edge_iterator ei, eend;
@@ -1074,7 +1083,7 @@ static void graphTransformFront(TaskiterGraph::graph_t &g, TaskMetadata *parent,
 	while (!ready->empty()) {
 		int width = ready->size();
 		// Calculate the average size of group
-		uint64_t groupsToMake = ((totalTime + us - 1) / us);
+		uint64_t groupsToMake = ((totalTime + ns - 1) / ns);
 		if (groupsToMake < HardwareInfo::getNumCpus())
 			groupsToMake = HardwareInfo::getNumCpus();
 
@@ -1184,7 +1193,7 @@ void TaskiterGraph::granularityTuning()
 #endif
 
 	// Front
-	graphTransformFront(_graph, parent, 1000 /* us minimum task */);
+	graphTransformFront(_graph, parent, 1000 * 1000 /* ns minimum task */);
 
 #if PRINT_TASKITER_GRAPH
 	if (_printGraph.getValue()) {
@@ -0,0 +1,167 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef CPU_CONTEXT_HPP
+#define CPU_CONTEXT_HPP
+
+#include <cassert>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <nosv.h>
+
+#include "HardwareInfo.hpp"
+#include "common/ErrorHandler.hpp"
+
+
+//! The CPU a worker thread is currently running on, cached per thread so the hot paths do
+//! not query nOS-V every time. Threads can only change CPU at scheduling points, so the
+//! context is refreshed when a task starts and invalidated after any call that may block.
+//!
+//! Only the blocking points of the runtime invalidate the context. Tasks must block through
+//! the runtime API rather than by calling nOS-V directly (e.g., nosv_pause, nosv_waitfor or
+//! nosv_yield), since they could resume on another CPU and keep using the per-CPU data of
+//! the previous one. Debug builds check that the cached CPU is still the current one
+class CPUContext {
+
+private:
+
+	//! The logical CPU id, or -1 if the context must be refreshed
+	int _cpuId;
+
+	//! The system CPU id, or -1 if it has not been queried yet
+	int _systemCpuId;
+
+	//! The logical NUMA node, or -1 if it has not been queried yet
+	int _numaNode;
+
+	//! The dependency data of the logical CPU
+	CPUDependencyData *_dependencyData;
+
+	static thread_local CPUContext _current;
+
+	static inline void refresh()
+	{
+		// Negative returned values mean the call failed, and the error is codified within
+		int cpuId = nosv_get_current_logical_cpu();
+		if (cpuId < 0) {
+			ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
+		}
+
+		_current._cpuId = cpuId;
+		_current._systemCpuId = -1;
+		_current._numaNode = -1;
+		_current._dependencyData = HardwareInfo::getCPUDependencyData(cpuId);
+	}
+
+	static inline CPUContext &get()
+	{
+		if (__builtin_expect(_current._cpuId < 0, 0)) {
+			refresh();
+		}
+
+		assert(_current._dependencyData != nullptr);
+		checkCurrent();
+		return _current;
+	}
+
+	//! \brief Check in debug builds that the thread did not change CPU without invalidating
+	//! its context
+	static inline void checkCurrent()
+	{
+#ifndef NDEBUG
+		int cpuId = nosv_get_current_logical_cpu();
+		if (cpuId >= 0 && cpuId != _current._cpuId) {
+			ErrorHandler::fail("The thread resumed on CPU ", cpuId, " but the runtime assumed CPU ",
+				_current._cpuId, ". Tasks must block through the runtime API instead of calling nOS-V directly");
+		}
+#endif
+	}
+
+public:
+
+	constexpr CPUContext() :
+		_cpuId(-1),
+		_systemCpuId(-1),
+		_numaNode(-1),
+		_dependencyData(nullptr)
+	{
+	}
+
+	//! \brief Refresh the context of the calling thread when a task starts running on it
+	static inline void taskStarted()
+	{
+		refresh();
+	}
+
+	//! \brief Invalidate the context of the calling thread after it may have been paused,
+	//! since it may resume on a different CPU
+	static inline void invalidate()
+	{
+		_current._cpuId = -1;
+	}
+
+	//! \brief Get the logical CPU id of the calling thread, which must be a nOS-V worker
+	static inline size_t getCpuId()
+	{
+		return (size_t) get()._cpuId;
+	}
+
+	//! \brief Get the logical CPU id of the calling thread, or -1 if it is not a nOS-V worker
+	static inline int tryGetCpuId()
+	{
+		if (__builtin_expect(_current._cpuId < 0, 0)) {
+			if (nosv_self() == nullptr)
+				return -1;
+			refresh();
+		}
+
+		checkCurrent();
+		return _current._cpuId;
+	}
+
+	//! \brief Get the system CPU id of the calling thread, which must be a nOS-V worker
+	static inline size_t getSystemCpuId()
+	{
+		CPUContext &context = get();
+		if (context._systemCpuId < 0) {
+			int systemCpuId = nosv_get_current_system_cpu();
+			if (systemCpuId < 0) {
+				ErrorHandler::fail("nosv_get_current_system_cpu failed: ", nosv_get_error_string(systemCpuId));
+			}
+			context._systemCpuId = systemCpuId;
+		}
+
+		return (size_t) context._systemCpuId;
+	}
+
+	//! \brief Get the logical NUMA node of the calling thread, which must be a nOS-V worker
+	static inline size_t getNumaNode()
+	{
+		CPUContext &context = get();
+		if (context._numaNode < 0) {
+			unsigned int systemCpu, systemNode;
+			int numaNode = 0;
+			if (syscall(SYS_getcpu, &systemCpu, &systemNode, nullptr) == 0) {
+				numaNode = nosv_get_logical_numa_id((int) systemNode);
+				if (numaNode < 0)
+					numaNode = 0;
+			}
+			context._numaNode = numaNode;
+		}
+
+		return (size_t) context._numaNode;
+	}
+
+	//! \brief Get the dependency data of the CPU of the calling thread, which must be a
+	//! nOS-V worker. The reduction slots of each CPU are also looked up with getCpuId
+	static inline CPUDependencyData *getDependencyData()
+	{
+		return get()._dependencyData;
+	}
+};
+
+#endif // CPU_CONTEXT_HPP
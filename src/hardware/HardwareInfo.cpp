@@ -4,8 +4,11 @@
 	Copyright (C) 2021 Barcelona Supercomputing Center (BSC)
 */
 
+#include "CPUContext.hpp"
 #include "HardwareInfo.hpp"
 
 
 size_t HardwareInfo::_numCpus(0);
 CPUDependencyData *HardwareInfo::_cpuDepDataArray;
+
+thread_local CPUContext CPUContext::_current;
@@ -0,0 +1,143 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unistd.h>
+
+#include "ChromeTrace.hpp"
+#include "common/ErrorHandler.hpp"
+#include "common/MathSupport.hpp"
+
+
+bool ChromeTrace::_enabled = false;
+size_t ChromeTrace::_capacity = 0;
+SpinLock ChromeTrace::_lock;
+std::vector<ChromeTrace::thread_buffer_t *> ChromeTrace::_buffers;
+thread_local ChromeTrace::thread_buffer_t *ChromeTrace::_threadBuffer = nullptr;
+EnvironmentVariable<std::string> ChromeTrace::_file("NODES_CHROME_TRACE", "");
+EnvironmentVariable<size_t> ChromeTrace::_bufferEvents("NODES_CHROME_TRACE_EVENTS", 256 * 1024);
+
+namespace {
+	//! Write a string as a JSON string, since task labels come from the user
+	struct JSONString {
+		const char *_string;
+	};
+
+	std::ostream &operator<<(std::ostream &os, const JSONString &json)
+	{
+		os << '"';
+		for (const char *c = json._string; *c != '\0'; ++c) {
+			if (*c == '"' || *c == '\\')
+				os << '\\' << *c;
+			else if ((unsigned char) *c < 0x20)
+				os << ' ';
+			else
+				os << *c;
+		}
+		return os << '"';
+	}
+}
+
+void ChromeTrace::initialize()
+{
+	if (_file.getValue().empty())
+		return;
+
+	ErrorHandler::failIf(_bufferEvents.getValue() == 0, "NODES_CHROME_TRACE_EVENTS must be greater than zero");
+
+	_capacity = MathSupport::roundToNextPowOf2(_bufferEvents.getValue());
+	_enabled = true;
+}
+
+void ChromeTrace::shutdown()
+{
+	if (!_enabled)
+		return;
+
+	// Threads that emit events after this point are not traced
+	_enabled = false;
+
+	writeTrace(_file.getValue());
+
+	std::lock_guard<SpinLock> guard(_lock);
+	for (thread_buffer_t *buffer : _buffers) {
+		delete[] buffer->_events;
+		delete buffer;
+	}
+	_buffers.clear();
+}
+
+ChromeTrace::thread_buffer_t *ChromeTrace::registerThread()
+{
+	thread_buffer_t *buffer = new thread_buffer_t();
+	buffer->_events = new event_t[_capacity];
+	buffer->_head.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<SpinLock> guard(_lock);
+	buffer->_threadId = _buffers.size();
+	_buffers.push_back(buffer);
+
+	_threadBuffer = buffer;
+	return buffer;
+}
+
+void ChromeTrace::writeTrace(const std::string &path)
+{
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		ErrorHandler::warn("Could not open ", path, " to write the trace");
+		return;
+	}
+
+	const pid_t pid = getpid();
+	uint64_t lastTimestamp = 0;
+
+	// Timestamps are written in microseconds with nanosecond precision
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::endl;
+
+	std::lock_guard<SpinLock> guard(_lock);
+	bool first = true;
+	for (thread_buffer_t *buffer : _buffers) {
+		const size_t tid = buffer->_threadId;
+		file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+			<< ", \"tid\": " << tid << ", \"args\": {\"name\": \"Thread " << tid << "\"}}";
+		first = false;
+
+		const size_t head = buffer->_head.load(std::memory_order_acquire);
+		const size_t begin = (head > _capacity) ? head - _capacity : 0;
+
+		// Regions whose beginning was overwritten are skipped, and regions that are still
+		// open are closed at the end of the trace
+		std::vector<const char *> open;
+		for (size_t e = begin; e < head; ++e) {
+			const event_t &event = buffer->_events[e & (_capacity - 1)];
+			if (event._phase == END) {
+				if (open.empty())
+					continue;
+				open.pop_back();
+			} else {
+				open.push_back(event._name);
+			}
+
+			lastTimestamp = std::max(lastTimestamp, event._timestamp);
+			file << ",\n{\"name\": " << JSONString{event._name} << ", \"ph\": \"" << (char) event._phase
+				<< "\", \"ts\": " << (event._timestamp / 1000.0) << ", \"pid\": " << pid
+				<< ", \"tid\": " << tid << "}";
+		}
+
+		while (!open.empty()) {
+			file << ",\n{\"name\": " << JSONString{open.back()} << ", \"ph\": \"E\", \"ts\": "
+				<< (lastTimestamp / 1000.0) << ", \"pid\": " << pid << ", \"tid\": " << tid << "}";
+			open.pop_back();
+		}
+	}
+
+	file << std::endl << "]}" << std::endl;
+}
@@ -0,0 +1,109 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef CHROME_TRACE_HPP
+#define CHROME_TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/Chrono.hpp"
+#include "common/EnvironmentVariable.hpp"
+#include "common/SpinLock.hpp"
+
+
+//! Tracing backend that does not depend on ovni. Events are recorded in per-thread ring
+//! buffers, which are only written by their thread, and are written at shutdown as a
+//! trace in the Chrome trace-event JSON format, which Perfetto can also open. When a
+//! buffer is full, the oldest events of the thread are overwritten
+class ChromeTrace {
+
+public:
+
+	enum phase_t : char {
+		BEGIN = 'B',
+		END = 'E'
+	};
+
+private:
+
+	struct event_t {
+		uint64_t _timestamp;
+
+		//! Name of the event, which must stay valid until shutdown
+		const char *_name;
+
+		phase_t _phase;
+	};
+
+	struct thread_buffer_t {
+		event_t *_events;
+
+		//! Number of events written since the beginning, the next one goes to the
+		//! position _head modulo the capacity
+		std::atomic<size_t> _head;
+
+		//! Sequential identifier of the thread in the trace
+		size_t _threadId;
+	};
+
+	static bool _enabled;
+
+	//! Capacity of the buffers, which is a power of two
+	static size_t _capacity;
+
+	static SpinLock _lock;
+	static std::vector<thread_buffer_t *> _buffers;
+
+	static thread_local thread_buffer_t *_threadBuffer;
+
+	//! Path of the trace file, or empty to disable the tracing
+	static EnvironmentVariable<std::string> _file;
+
+	//! Number of events kept per thread
+	static EnvironmentVariable<size_t> _bufferEvents;
+
+	//! \brief Create the buffer of the calling thread
+	static thread_buffer_t *registerThread();
+
+	static void writeTrace(const std::string &path);
+
+public:
+
+	static void initialize();
+
+	//! \brief Write the trace and release the buffers
+	static void shutdown();
+
+	static inline bool isEnabled()
+	{
+		return _enabled;
+	}
+
+	//! \brief Record an event in the buffer of the calling thread
+	//!
+	//! \param[in] name The name of the event, which must stay valid until shutdown
+	//! \param[in] phase Whether the event begins or ends a region
+	static inline void emit(const char *name, phase_t phase)
+	{
+		thread_buffer_t *buffer = _threadBuffer;
+		if (__builtin_expect(buffer == nullptr, 0))
+			buffer = registerThread();
+
+		const size_t head = buffer->_head.load(std::memory_order_relaxed);
+		event_t &event = buffer->_events[head & (_capacity - 1)];
+		event._timestamp = Chrono::nowNanoseconds();
+		event._name = name;
+		event._phase = phase;
+
+		buffer->_head.store(head + 1, std::memory_order_release);
+	}
+};
+
+#endif // CHROME_TRACE_HPP
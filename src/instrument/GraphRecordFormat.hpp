@@ -0,0 +1,89 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef GRAPH_RECORD_FORMAT_HPP
+#define GRAPH_RECORD_FORMAT_HPP
+
+#include <cstdint>
+
+
+//! Layout of the task graph files written by the GraphRecorder and read by the replay tool.
+//! A file starts with the magic string and is followed by a sequence of records, each one
+//! made of its kind byte and the corresponding struct. Records of different threads are
+//! interleaved, so readers must load the whole file before linking tasks and accesses.
+//! Fields are stored in the byte order of the recording machine
+namespace GraphRecordFormat {
+
+	static constexpr char MAGIC[8] = { 'N', 'O', 'D', 'E', 'S', 'G', 'R', '1' };
+
+	enum record_kind_t : uint8_t {
+		//! A task type, followed by its label
+		TYPE_RECORD = 0,
+		//! A submitted task
+		TASK_RECORD,
+		//! A data access registered by a task
+		ACCESS_RECORD,
+		//! A taskwait of a task
+		TASKWAIT_RECORD,
+		//! An execution of a task, which may appear several times for tasks that run
+		//! more than once, such as coroutines or the children of taskiters
+		EXECUTION_RECORD
+	};
+
+	enum task_flags_t : uint8_t {
+		IF0_TASK = 1,
+		//! The task has the wait clause
+		WAIT_TASK = 2
+	};
+
+	struct __attribute__((packed)) type_record_t {
+		uint32_t _typeId;
+		uint32_t _labelLength;
+	};
+
+	//! Task and taskwait identifiers share the same sequence, so they also give the order
+	//! in which a task created its children and waited for them
+	struct __attribute__((packed)) task_record_t {
+		uint64_t _taskId;
+
+		//! Identifier of the parent, or 0 if the task has none
+		uint64_t _parentId;
+
+		//! Execution time of the parent before submitting the task, in nanoseconds
+		uint64_t _offset;
+
+		uint32_t _typeId;
+		uint8_t _flags;
+	};
+
+	struct __attribute__((packed)) access_record_t {
+		uint64_t _taskId;
+		uint64_t _address;
+		uint64_t _length;
+
+		//! A DataAccessType
+		uint8_t _type;
+		uint8_t _weak;
+	};
+
+	struct __attribute__((packed)) taskwait_record_t {
+		uint64_t _taskId;
+		uint64_t _sequence;
+
+		//! Execution time of the task before the taskwait, in nanoseconds
+		uint64_t _offset;
+	};
+
+	struct __attribute__((packed)) execution_record_t {
+		uint64_t _taskId;
+
+		//! Execution time of the task, without the time blocked in taskwaits and the time
+		//! running other tasks inline, in nanoseconds
+		uint64_t _duration;
+	};
+}
+
+#endif // GRAPH_RECORD_FORMAT_HPP
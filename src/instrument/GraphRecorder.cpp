@@ -0,0 +1,100 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <algorithm>
+#include <mutex>
+
+#include "GraphRecorder.hpp"
+#include "common/ErrorHandler.hpp"
+
+
+bool GraphRecorder::_enabled = false;
+FILE *GraphRecorder::_file = nullptr;
+SpinLock GraphRecorder::_lock;
+std::vector<GraphRecorder::thread_buffer_t *> GraphRecorder::_buffers;
+std::atomic<uint64_t> GraphRecorder::_sequence(1);
+std::atomic<uint32_t> GraphRecorder::_typeIds(1);
+thread_local GraphRecorder::thread_buffer_t *GraphRecorder::_threadBuffer = nullptr;
+thread_local GraphRecorder::task_timer_t GraphRecorder::_timer = { 0, 0, 0 };
+EnvironmentVariable<std::string> GraphRecorder::_path("NODES_GRAPH_RECORD", "");
+
+void GraphRecorder::initialize()
+{
+	if (_path.getValue().empty())
+		return;
+
+	_file = fopen(_path.getValue().c_str(), "wb");
+	if (_file == nullptr) {
+		ErrorHandler::warn("Could not open ", _path.getValue(), " to record the task graph");
+		return;
+	}
+
+	if (fwrite(GraphRecordFormat::MAGIC, sizeof(GraphRecordFormat::MAGIC), 1, _file) != 1)
+		ErrorHandler::fail("Could not write the task graph to ", _path.getValue());
+
+	_enabled = true;
+}
+
+void GraphRecorder::shutdown()
+{
+	if (!_enabled)
+		return;
+
+	// Tasks that run after this point are not recorded
+	_enabled = false;
+
+	std::lock_guard<SpinLock> guard(_lock);
+	for (thread_buffer_t *buffer : _buffers) {
+		if (buffer->_size > 0 && fwrite(buffer->_data, buffer->_size, 1, _file) != 1)
+			ErrorHandler::fail("Could not write the task graph to ", _path.getValue());
+
+		delete[] buffer->_data;
+		delete buffer;
+	}
+	_buffers.clear();
+
+	fclose(_file);
+	_file = nullptr;
+}
+
+uint32_t GraphRecorder::recordType(const std::string &label)
+{
+	if (!_enabled)
+		return 0;
+
+	// Keep the record within a buffer even for absurdly long labels
+	const size_t maxLength = BUFFER_SIZE / 2;
+
+	GraphRecordFormat::type_record_t record;
+	record._typeId = _typeIds.fetch_add(1, std::memory_order_relaxed);
+	record._labelLength = (uint32_t) std::min(label.size(), maxLength);
+
+	write(GraphRecordFormat::TYPE_RECORD, record, label.c_str(), record._labelLength);
+
+	return record._typeId;
+}
+
+GraphRecorder::thread_buffer_t *GraphRecorder::registerThread()
+{
+	thread_buffer_t *buffer = new thread_buffer_t();
+	buffer->_data = new char[BUFFER_SIZE];
+	buffer->_size = 0;
+
+	std::lock_guard<SpinLock> guard(_lock);
+	_buffers.push_back(buffer);
+
+	_threadBuffer = buffer;
+	return buffer;
+}
+
+void GraphRecorder::flush(thread_buffer_t *buffer)
+{
+	std::lock_guard<SpinLock> guard(_lock);
+	if (_file != nullptr && fwrite(buffer->_data, buffer->_size, 1, _file) != 1)
+		ErrorHandler::fail("Could not write the task graph to ", _path.getValue());
+
+	buffer->_size = 0;
+}
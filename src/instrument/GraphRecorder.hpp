@@ -0,0 +1,235 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef GRAPH_RECORDER_HPP
+#define GRAPH_RECORDER_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "GraphRecordFormat.hpp"
+#include "common/Chrono.hpp"
+#include "common/EnvironmentVariable.hpp"
+#include "common/SpinLock.hpp"
+#include "dependencies/DataAccessType.hpp"
+#include "tasks/TaskMetadata.hpp"
+
+
+//! Records the task graph of a run in a compact binary file (see GraphRecordFormat), with
+//! the type, accesses and execution time of each task, so it can be replayed offline by the
+//! nodes-replay tool. Records are appended to per-thread buffers, which are written to the
+//! file under a lock when they fill up and at shutdown
+class GraphRecorder {
+
+public:
+
+	//! The timing of the task that a thread is running, which is saved while the thread runs
+	//! another task inline and restored afterwards
+	struct task_timer_t {
+		//! When the task started running, or 0 if the thread is not running a task
+		uint64_t _start;
+
+		//! Time that must not be accounted to the task, such as the time blocked in
+		//! taskwaits or the time running other tasks inline
+		uint64_t _excluded;
+
+		//! When the task blocked, if it is blocked
+		uint64_t _blockStart;
+	};
+
+private:
+
+	struct thread_buffer_t {
+		char *_data;
+		size_t _size;
+	};
+
+	//! Size of the per-thread buffers in bytes
+	static const size_t BUFFER_SIZE = 64 * 1024;
+
+	static bool _enabled;
+
+	static FILE *_file;
+
+	static SpinLock _lock;
+	static std::vector<thread_buffer_t *> _buffers;
+
+	//! Next identifier of a task or taskwait. The value 0 is reserved for tasks without parent
+	static std::atomic<uint64_t> _sequence;
+
+	//! Next identifier of a task type
+	static std::atomic<uint32_t> _typeIds;
+
+	static thread_local thread_buffer_t *_threadBuffer;
+	static thread_local task_timer_t _timer;
+
+	//! Path of the graph file, or empty to disable the recording
+	static EnvironmentVariable<std::string> _path;
+
+	//! \brief Create the buffer of the calling thread
+	static thread_buffer_t *registerThread();
+
+	//! \brief Write the contents of a buffer to the file and empty it
+	static void flush(thread_buffer_t *buffer);
+
+	//! \brief Append a record to the buffer of the calling thread
+	//!
+	//! \param[in] kind The kind of the record
+	//! \param[in] record The record
+	//! \param[in] extra Bytes to append after the record, such as the label of a type
+	//! \param[in] extraLength The number of extra bytes
+	template <typename T>
+	static inline void write(GraphRecordFormat::record_kind_t kind, const T &record, const char *extra = nullptr, size_t extraLength = 0)
+	{
+		thread_buffer_t *buffer = _threadBuffer;
+		if (__builtin_expect(buffer == nullptr, 0))
+			buffer = registerThread();
+
+		const size_t size = sizeof(kind) + sizeof(T) + extraLength;
+		assert(size <= BUFFER_SIZE);
+		if (buffer->_size + size > BUFFER_SIZE)
+			flush(buffer);
+
+		char *position = buffer->_data + buffer->_size;
+		position[0] = (char) kind;
+		__builtin_memcpy(position + sizeof(kind), &record, sizeof(T));
+		if (extraLength > 0)
+			__builtin_memcpy(position + sizeof(kind) + sizeof(T), extra, extraLength);
+
+		buffer->_size += size;
+	}
+
+	//! \brief Get the execution time of the task running in the calling thread, or 0 if none
+	static inline uint64_t getElapsed()
+	{
+		if (_timer._start == 0)
+			return 0;
+
+		const uint64_t elapsed = Chrono::nowNanoseconds() - _timer._start;
+		return (elapsed > _timer._excluded) ? elapsed - _timer._excluded : 0;
+	}
+
+public:
+
+	static void initialize();
+
+	//! \brief Write the pending records and close the file
+	static void shutdown();
+
+	static inline bool isEnabled()
+	{
+		return _enabled;
+	}
+
+	//! \brief Record a task type
+	//!
+	//! \param[in] label The label of the type
+	//!
+	//! \returns The identifier of the type in the graph, or 0 if the recording is disabled
+	static uint32_t recordType(const std::string &label);
+
+	//! \brief Record a task when it is submitted, and assign its identifier in the graph
+	//!
+	//! \param[in,out] task The submitted task, whose parent must have been set
+	//! \param[in] typeId The identifier of the type of the task
+	static inline void recordTask(TaskMetadata *task, uint32_t typeId)
+	{
+		GraphRecordFormat::task_record_t record;
+		record._taskId = _sequence.fetch_add(1, std::memory_order_relaxed);
+		record._parentId = (task->getParent() != nullptr) ? task->getParent()->getRecordId() : 0;
+		record._offset = getElapsed();
+		record._typeId = typeId;
+		record._flags = 0;
+		if (task->isIf0())
+			record._flags |= GraphRecordFormat::IF0_TASK;
+		if (task->mustDelayRelease())
+			record._flags |= GraphRecordFormat::WAIT_TASK;
+
+		task->setRecordId(record._taskId);
+
+		write(GraphRecordFormat::TASK_RECORD, record);
+	}
+
+	//! \brief Record an access of a task, once per call to the registration functions
+	static inline void recordAccess(TaskMetadata *task, DataAccessType type, bool weak, void *address, size_t length)
+	{
+		GraphRecordFormat::access_record_t record;
+		record._taskId = task->getRecordId();
+		record._address = (uint64_t) address;
+		record._length = length;
+		record._type = (uint8_t) type;
+		record._weak = weak;
+
+		write(GraphRecordFormat::ACCESS_RECORD, record);
+	}
+
+	//! \brief Record a taskwait of the task running in the calling thread, which is
+	//! considered blocked until exitBlocking is called
+	static inline void recordTaskwait(TaskMetadata *task)
+	{
+		GraphRecordFormat::taskwait_record_t record;
+		record._taskId = task->getRecordId();
+		record._sequence = _sequence.fetch_add(1, std::memory_order_relaxed);
+		record._offset = getElapsed();
+
+		write(GraphRecordFormat::TASKWAIT_RECORD, record);
+
+		enterBlocking();
+	}
+
+	//! \brief The task running in the calling thread may block, so the time until
+	//! exitBlocking is not accounted to it
+	static inline void enterBlocking()
+	{
+		_timer._blockStart = Chrono::nowNanoseconds();
+	}
+
+	static inline void exitBlocking()
+	{
+		_timer._excluded += Chrono::nowNanoseconds() - _timer._blockStart;
+	}
+
+	//! \brief A task starts running in the calling thread
+	//!
+	//! \returns The timing of the task that the thread was running, if any, which must
+	//! be passed to taskEnded
+	static inline task_timer_t taskStarted()
+	{
+		task_timer_t previous = _timer;
+		_timer._start = Chrono::nowNanoseconds();
+		_timer._excluded = 0;
+		return previous;
+	}
+
+	//! \brief A task stops running in the calling thread, either because it finished or
+	//! because it was suspended
+	//!
+	//! \param[in] task The task
+	//! \param[in] previous The timing returned by taskStarted
+	static inline void taskEnded(TaskMetadata *task, const task_timer_t &previous)
+	{
+		const uint64_t end = Chrono::nowNanoseconds();
+		const uint64_t elapsed = end - _timer._start;
+
+		GraphRecordFormat::execution_record_t record;
+		record._taskId = task->getRecordId();
+		record._duration = (elapsed > _timer._excluded) ? elapsed - _timer._excluded : 0;
+
+		write(GraphRecordFormat::EXECUTION_RECORD, record);
+
+		// The whole execution of an inline task is excluded from the task that ran it
+		_timer = previous;
+		if (_timer._start != 0)
+			_timer._excluded += elapsed;
+	}
+};
+
+#endif // GRAPH_RECORDER_HPP
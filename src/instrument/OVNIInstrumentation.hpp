@@ -7,29 +7,47 @@
 #ifndef OVNI_INSTRUMENTATION_HPP
 #define OVNI_INSTRUMENTATION_HPP
 
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 
 #ifdef ENABLE_OVNI_INSTRUMENTATION
 #include <ovni.h>
 #endif
 
+#include "ChromeTrace.hpp"
 #include "common/EnvironmentVariable.hpp"
+#include "common/ErrorHandler.hpp"
 
+//! Instrumentation points of the runtime, which are dispatched to the enabled backends.
+//! Building with DISABLE_INSTRUMENTATION turns every point into an empty function. Otherwise,
+//! each point costs a single branch on a global flag while no backend is enabled, and the
+//! per-thread setup of the backends only happens when an event is actually emitted
 class Instrument {
 
 private:
-	static inline bool _enabled = false;
-	thread_local static inline bool _init = false;
+	enum backend_t : uint8_t {
+		OVNI_BACKEND = 1,
+		CHROME_BACKEND = 2
+	};
+
+	//! Mask of the enabled backends, which is only written at initialization and shutdown
+	static inline uint8_t _backends = 0;
+
+	thread_local static inline bool _ovniThreadInit = false;
 
 private:
-#ifdef ENABLE_OVNI_INSTRUMENTATION
-	static inline void emitOvniEvent(const char *mcv)
+	//! \brief Emit an event in the enabled backends, out of line to keep the
+	//! instrumentation points small
+	__attribute__((noinline)) static void emitEnabledEvent(const char *mcv, const char *name, ChromeTrace::phase_t phase)
 	{
-		if (_enabled) {
-			if (!_init) {
+#ifdef ENABLE_OVNI_INSTRUMENTATION
+		// Tasks are traced by nOS-V itself and have no ovni event here
+		if ((_backends & OVNI_BACKEND) && mcv != nullptr) {
+			if (!_ovniThreadInit) {
 				// Thread stream initialized by nOS-V
 				ovni_thread_require("nodes", "1.0.0");
-				_init = true;
+				_ovniThreadInit = true;
 			}
 
 			struct ovni_ev ev = {};
@@ -39,99 +57,154 @@ private:
 
 			ovni_ev_emit(&ev);
 		}
+#else
+		(void) mcv;
+#endif
+
+		if (_backends & CHROME_BACKEND)
+			ChromeTrace::emit(name, phase);
+	}
+
+#ifndef DISABLE_INSTRUMENTATION
+	//! \brief Emit an event in the enabled tracing backends, if any
+	static inline void emitEvent(const char *mcv, const char *name, ChromeTrace::phase_t phase)
+	{
+		if (__builtin_expect(_backends != 0, 0))
+			emitEnabledEvent(mcv, name, phase);
 	}
 #else
-	static inline void emitOvniEvent(const char *)
+	static inline void emitEvent(const char *, const char *, ChromeTrace::phase_t)
 	{
 	}
 #endif
 
 public:
 
-	static inline void initializeOvni()
+	//! \brief Enable the backends requested through the environment
+	static inline void initialize()
+	{
+		EnvironmentVariable<bool> ovni("NODES_OVNI", false);
+
+#ifndef DISABLE_INSTRUMENTATION
+		ChromeTrace::initialize();
+
+		uint8_t backends = 0;
+#ifdef ENABLE_OVNI_INSTRUMENTATION
+		if (ovni.getValue())
+			backends |= OVNI_BACKEND;
+#endif
+		if (ChromeTrace::isEnabled())
+			backends |= CHROME_BACKEND;
+
+		_backends = backends;
+#else
+		EnvironmentVariable<std::string> chromeTrace("NODES_CHROME_TRACE", "");
+		ErrorHandler::warnIf(ovni.getValue() || !chromeTrace.getValue().empty(),
+			"Tracing is ignored since NODES was built without instrumentation");
+#endif
+	}
+
+	//! \brief Disable the backends and write their output
+	static inline void shutdown()
+	{
+		_backends = 0;
+
+		ChromeTrace::shutdown();
+	}
+
+	//! \brief A task starts running in the calling thread. ovni already traces tasks
+	//! through nOS-V, so only the other backends record it
+	//!
+	//! \param[in] label The label of the task type, which must stay valid until shutdown
+	static inline void startTask(const char *label)
+	{
+		emitEvent(nullptr, label, ChromeTrace::BEGIN);
+	}
+
+	//! \brief The task started with startTask finished running in the calling thread
+	static inline void endTask(const char *label)
 	{
-		EnvironmentVariable<bool> envvar("NODES_OVNI", false);
-		_enabled = envvar.getValue();
+		emitEvent(nullptr, label, ChromeTrace::END);
 	}
 
 	static inline void enterRegisterAccesses()
 	{
-		emitOvniEvent("DR[");
+		emitEvent("DR[", "Register accesses", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitRegisterAccesses()
 	{
-		emitOvniEvent("DR]");
+		emitEvent("DR]", "Register accesses", ChromeTrace::END);
 	}
 
 	static inline void enterUnregisterAccesses()
 	{
-		emitOvniEvent("DU[");
+		emitEvent("DU[", "Unregister accesses", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitUnregisterAccesses()
 	{
-		emitOvniEvent("DU]");
+		emitEvent("DU]", "Unregister accesses", ChromeTrace::END);
 	}
 
 	static inline void enterWaitIf0()
 	{
-		emitOvniEvent("DW[");
+		emitEvent("DW[", "Wait if0", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitWaitIf0()
 	{
-		emitOvniEvent("DW]");
+		emitEvent("DW]", "Wait if0", ChromeTrace::END);
 	}
 
 	static inline void enterInlineIf0()
 	{
-		emitOvniEvent("DI[");
+		emitEvent("DI[", "Inline if0", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitInlineIf0()
 	{
-		emitOvniEvent("DI]");
+		emitEvent("DI]", "Inline if0", ChromeTrace::END);
 	}
 
 	static inline void enterTaskWait()
 	{
-		emitOvniEvent("DT[");
+		emitEvent("DT[", "Taskwait", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitTaskWait()
 	{
-		emitOvniEvent("DT]");
+		emitEvent("DT]", "Taskwait", ChromeTrace::END);
 	}
 
 	static inline void enterCreateTask()
 	{
-		emitOvniEvent("DC[");
+		emitEvent("DC[", "Create task", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitCreateTask()
 	{
-		emitOvniEvent("DC]");
+		emitEvent("DC]", "Create task", ChromeTrace::END);
 	}
 
 	static inline void enterSubmitTask()
 	{
-		emitOvniEvent("DS[");
+		emitEvent("DS[", "Submit task", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitSubmitTask()
 	{
-		emitOvniEvent("DS]");
+		emitEvent("DS]", "Submit task", ChromeTrace::END);
 	}
 
 	static inline void enterSpawnFunction()
 	{
-		emitOvniEvent("DP[");
+		emitEvent("DP[", "Spawn function", ChromeTrace::BEGIN);
 	}
 
 	static inline void exitSpawnFunction()
 	{
-		emitOvniEvent("DP]");
+		emitEvent("DP]", "Spawn function", ChromeTrace::END);
 	}
 
 };
@@ -0,0 +1,174 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Statistics.hpp"
+#include "common/ErrorHandler.hpp"
+#include "hardware/HardwareInfo.hpp"
+
+
+bool Statistics::_enabled = false;
+Statistics::padded_statistics_t *Statistics::_statistics = nullptr;
+size_t Statistics::_numCpus = 0;
+EnvironmentVariable<bool> Statistics::_enabledVariable("NODES_STATS", false);
+EnvironmentVariable<std::string> Statistics::_jsonFile("NODES_STATS_JSON", "");
+
+const char *Statistics::_counterNames[NUM_COUNTERS] = {
+	"tasks_created",
+	"tasks_submitted",
+	"tasks_inlined",
+	"tasks_final_cutoff",
+	"local_metadata_allocations",
+	"dependency_registrations",
+	"commutative_waits",
+	"taskwait_blocks",
+	"user_mutex_contentions",
+	"reduction_slot_allocations",
+	"reduction_slot_fallbacks"
+};
+
+const char *Statistics::_histogramNames[NUM_HISTOGRAMS] = {
+	"satisfied_flush_size"
+};
+
+void Statistics::initialize()
+{
+	// Writing the JSON file implies collecting the statistics
+	if (!_enabledVariable.getValue() && _jsonFile.getValue().empty())
+		return;
+
+	_numCpus = HardwareInfo::getNumCpus();
+	_statistics = new padded_statistics_t[_numCpus + 1];
+
+	for (size_t cpu = 0; cpu <= _numCpus; ++cpu) {
+		std::fill_n(_statistics[cpu]._counters, (size_t) NUM_COUNTERS, 0);
+		for (size_t h = 0; h < NUM_HISTOGRAMS; ++h)
+			std::fill_n(_statistics[cpu]._histograms[h], HISTOGRAM_BUCKETS, 0);
+	}
+
+	_enabled = true;
+}
+
+void Statistics::shutdown()
+{
+	if (!_enabled)
+		return;
+
+	// Stop collecting before reading the counters of the other CPUs
+	_enabled = false;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (_enabledVariable.getValue())
+		printReport();
+
+	if (!_jsonFile.getValue().empty())
+		writeJSON(_jsonFile.getValue());
+
+	delete[] _statistics;
+	_statistics = nullptr;
+}
+
+size_t Statistics::getTotal(counter_t counter)
+{
+	if (_statistics == nullptr)
+		return 0;
+
+	size_t total = 0;
+	for (size_t cpu = 0; cpu <= _numCpus; ++cpu)
+		total += _statistics[cpu]._counters[counter];
+
+	return total;
+}
+
+void Statistics::printReport()
+{
+	std::ostringstream oss;
+	oss << "NODES statistics (total: min/max per CPU, external threads)" << std::endl;
+
+	for (size_t c = 0; c < NUM_COUNTERS; ++c) {
+		size_t minimum = SIZE_MAX;
+		size_t maximum = 0;
+		for (size_t cpu = 0; cpu < _numCpus; ++cpu) {
+			minimum = std::min(minimum, _statistics[cpu]._counters[c]);
+			maximum = std::max(maximum, _statistics[cpu]._counters[c]);
+		}
+
+		oss << "  " << _counterNames[c] << ": " << getTotal((counter_t) c)
+			<< " (" << minimum << "/" << maximum << ", "
+			<< _statistics[_numCpus]._counters[c] << ")" << std::endl;
+	}
+
+	for (size_t h = 0; h < NUM_HISTOGRAMS; ++h) {
+		oss << "  " << _histogramNames[h] << ":" << std::endl;
+
+		for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+			size_t total = 0;
+			for (size_t cpu = 0; cpu <= _numCpus; ++cpu)
+				total += _statistics[cpu]._histograms[h][bucket];
+
+			if (total == 0)
+				continue;
+
+			oss << "    [" << ((bucket > 0) ? (1ULL << bucket) : 0) << ", "
+				<< ((bucket + 1 < HISTOGRAM_BUCKETS) ? (2ULL << bucket) - 1 : ~0ULL) << "]: "
+				<< total << std::endl;
+		}
+	}
+
+	std::cerr << oss.str();
+}
+
+void Statistics::writeJSON(const std::string &path)
+{
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		ErrorHandler::warn("Could not open ", path, " to write the statistics");
+		return;
+	}
+
+	file << "{" << std::endl;
+	file << "\t\"cpus\": " << _numCpus << "," << std::endl;
+	file << "\t\"counters\": {" << std::endl;
+
+	for (size_t c = 0; c < NUM_COUNTERS; ++c) {
+		file << "\t\t\"" << _counterNames[c] << "\": {\"total\": " << getTotal((counter_t) c);
+		file << ", \"external\": " << _statistics[_numCpus]._counters[c] << ", \"per_cpu\": [";
+		for (size_t cpu = 0; cpu < _numCpus; ++cpu)
+			file << ((cpu > 0) ? ", " : "") << _statistics[cpu]._counters[c];
+		file << "]}" << ((c + 1 < NUM_COUNTERS) ? "," : "") << std::endl;
+	}
+
+	file << "\t}," << std::endl;
+	file << "\t\"histograms\": {" << std::endl;
+
+	for (size_t h = 0; h < NUM_HISTOGRAMS; ++h) {
+		file << "\t\t\"" << _histogramNames[h] << "\": [";
+
+		bool first = true;
+		for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+			size_t total = 0;
+			for (size_t cpu = 0; cpu <= _numCpus; ++cpu)
+				total += _statistics[cpu]._histograms[h][bucket];
+
+			if (total == 0)
+				continue;
+
+			file << (first ? "" : ", ") << "{\"min\": " << ((bucket > 0) ? (1ULL << bucket) : 0)
+				<< ", \"max\": " << ((bucket + 1 < HISTOGRAM_BUCKETS) ? (2ULL << bucket) - 1 : ~0ULL)
+				<< ", \"count\": " << total << "}";
+			first = false;
+		}
+
+		file << "]" << ((h + 1 < NUM_HISTOGRAMS) ? "," : "") << std::endl;
+	}
+
+	file << "\t}" << std::endl;
+	file << "}" << std::endl;
+}
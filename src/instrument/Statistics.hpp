@@ -0,0 +1,132 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <climits>
+#include <cstddef>
+#include <string>
+
+#include "common/EnvironmentVariable.hpp"
+#include "common/Padding.hpp"
+#include "hardware/CPUContext.hpp"
+
+
+//! Runtime statistics kept in per-CPU counters and histograms, which are aggregated and
+//! reported at shutdown. Each CPU only updates its own counters, since only one worker runs
+//! on a CPU at a time, so updates are plain increments. Threads that are not nOS-V workers
+//! use an additional set of counters that is updated atomically
+class Statistics {
+
+public:
+
+	enum counter_t {
+		TASKS_CREATED = 0,
+		TASKS_SUBMITTED,
+		TASKS_INLINED,
+		TASKS_FINAL_CUTOFF,
+		LOCAL_METADATA_ALLOCATIONS,
+		DEPENDENCY_REGISTRATIONS,
+		COMMUTATIVE_WAITS,
+		TASKWAIT_BLOCKS,
+		USER_MUTEX_CONTENTIONS,
+		REDUCTION_SLOT_ALLOCATIONS,
+		REDUCTION_SLOT_FALLBACKS,
+		NUM_COUNTERS
+	};
+
+	enum histogram_t {
+		SATISFIED_FLUSH_SIZE = 0,
+		NUM_HISTOGRAMS
+	};
+
+	//! Number of buckets of the histograms, where the bucket i counts the values in
+	//! [2^i, 2^(i+1)), and zeros are accounted in the first one
+	static constexpr size_t HISTOGRAM_BUCKETS = 64;
+
+private:
+
+	struct cpu_statistics_t {
+		size_t _counters[NUM_COUNTERS];
+		size_t _histograms[NUM_HISTOGRAMS][HISTOGRAM_BUCKETS];
+	};
+
+	typedef Padded<cpu_statistics_t> padded_statistics_t;
+
+	//! Whether the statistics are enabled, copied from the environment at initialization
+	static bool _enabled;
+
+	//! The statistics of each CPU, followed by the ones of the external threads
+	static padded_statistics_t *_statistics;
+
+	static size_t _numCpus;
+
+	static EnvironmentVariable<bool> _enabledVariable;
+
+	//! Path of the file where the statistics are written in JSON, or empty for none
+	static EnvironmentVariable<std::string> _jsonFile;
+
+	static const char *_counterNames[NUM_COUNTERS];
+	static const char *_histogramNames[NUM_HISTOGRAMS];
+
+	static inline size_t getBucket(size_t value)
+	{
+		if (value == 0)
+			return 0;
+		return (sizeof(unsigned long long) * CHAR_BIT - 1) - __builtin_clzll(value);
+	}
+
+	static void printReport();
+
+	static void writeJSON(const std::string &path);
+
+public:
+
+	static void initialize();
+
+	//! \brief Print the report and release the counters
+	static void shutdown();
+
+	static inline bool isEnabled()
+	{
+		return _enabled;
+	}
+
+	//! \brief Add to a counter of the calling CPU
+	static inline void increment(counter_t counter, size_t amount = 1)
+	{
+		if (__builtin_expect(!_enabled, 1))
+			return;
+
+		int cpuId = CPUContext::tryGetCpuId();
+		if (cpuId >= 0) {
+			_statistics[cpuId]._counters[counter] += amount;
+		} else {
+			__atomic_fetch_add(&_statistics[_numCpus]._counters[counter], amount, __ATOMIC_RELAXED);
+		}
+	}
+
+	//! \brief Account a value in a histogram of the calling CPU
+	static inline void record(histogram_t histogram, size_t value)
+	{
+		if (__builtin_expect(!_enabled, 1))
+			return;
+
+		size_t bucket = getBucket(value);
+		int cpuId = CPUContext::tryGetCpuId();
+		if (cpuId >= 0) {
+			_statistics[cpuId]._histograms[histogram][bucket]++;
+		} else {
+			__atomic_fetch_add(&_statistics[_numCpus]._histograms[histogram][bucket], 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	//! \brief Get the sum of a counter over all CPUs
+	static size_t getTotal(counter_t counter);
+};
+
+#endif // STATISTICS_HPP
@@ -0,0 +1,81 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <cassert>
+#include <mutex>
+
+#include <nosv/hwinfo.h>
+
+#include "MemoryAllocator.hpp"
+#include "ReductionBufferPool.hpp"
+
+
+ReductionBufferPool::numa_pool_t *ReductionBufferPool::_pools = nullptr;
+size_t ReductionBufferPool::_numNodes = 0;
+EnvironmentVariable<size_t> ReductionBufferPool::_maxCachedBytes("NODES_REDUCTION_POOL_SIZE", 256 * 1024 * 1024);
+
+void ReductionBufferPool::initialize()
+{
+	int numNodes = nosv_get_num_numa_nodes();
+	_numNodes = (numNodes > 0) ? numNodes : 1;
+
+	_pools = new numa_pool_t[_numNodes];
+	for (size_t node = 0; node < _numNodes; ++node)
+		_pools[node]._cachedBytes = 0;
+}
+
+void ReductionBufferPool::shutdown()
+{
+	for (size_t node = 0; node < _numNodes; ++node) {
+		for (auto &bucket : _pools[node]._buffers) {
+			for (void *buffer : bucket.second)
+				MemoryAllocator::free(buffer, bucket.first);
+		}
+	}
+
+	delete[] _pools;
+	_pools = nullptr;
+}
+
+void *ReductionBufferPool::allocate(size_t length, size_t numaNode)
+{
+	assert(_pools != nullptr);
+
+	if (numaNode < _numNodes) {
+		numa_pool_t &pool = _pools[numaNode];
+		std::lock_guard<PaddedSpinLock<>> guard(pool._lock);
+
+		auto it = pool._buffers.find(length);
+		if (it != pool._buffers.end() && !it->second.empty()) {
+			void *buffer = it->second.back();
+			it->second.pop_back();
+			pool._cachedBytes -= length;
+			return buffer;
+		}
+	}
+
+	// New buffers get their pages when the owning CPU initializes them
+	return MemoryAllocator::alloc(length);
+}
+
+void ReductionBufferPool::release(void *buffer, size_t length, size_t numaNode)
+{
+	assert(_pools != nullptr);
+	assert(buffer != nullptr);
+
+	if (numaNode < _numNodes) {
+		numa_pool_t &pool = _pools[numaNode];
+		std::lock_guard<PaddedSpinLock<>> guard(pool._lock);
+
+		if (pool._cachedBytes + length <= _maxCachedBytes.getValue()) {
+			pool._buffers[length].push_back(buffer);
+			pool._cachedBytes += length;
+			return;
+		}
+	}
+
+	MemoryAllocator::free(buffer, length);
+}
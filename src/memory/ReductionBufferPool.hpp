@@ -0,0 +1,60 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef REDUCTION_BUFFER_POOL_HPP
+#define REDUCTION_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "common/EnvironmentVariable.hpp"
+#include "common/PaddedSpinLock.hpp"
+
+
+//! Pools of private reduction buffers, one per NUMA node and bucketed by length. Buffers are
+//! first touched by the CPU that initializes them and are only handed out again to CPUs of
+//! the same NUMA node, so reductions inside loops reuse local memory instead of allocating it
+class ReductionBufferPool {
+
+	struct numa_pool_t {
+		PaddedSpinLock<> _lock;
+
+		//! Free buffers indexed by their length
+		std::unordered_map<size_t, std::vector<void *>> _buffers;
+
+		//! Total length of the free buffers
+		size_t _cachedBytes;
+	};
+
+	static numa_pool_t *_pools;
+
+	static size_t _numNodes;
+
+	//! Maximum length of the free buffers kept by each NUMA node
+	static EnvironmentVariable<size_t> _maxCachedBytes;
+
+public:
+
+	static void initialize();
+
+	static void shutdown();
+
+	//! \brief Get a buffer for the private storage of a reduction
+	//!
+	//! \param[in] length The length of the buffer, which must be padded to cache lines
+	//! \param[in] numaNode The logical NUMA node of the CPU that will use it
+	static void *allocate(size_t length, size_t numaNode);
+
+	//! \brief Return a buffer obtained with allocate
+	//!
+	//! \param[in] buffer The buffer
+	//! \param[in] length The length that was requested for the buffer
+	//! \param[in] numaNode The NUMA node that was requested for the buffer
+	static void release(void *buffer, size_t length, size_t numaNode);
+};
+
+#endif // REDUCTION_BUFFER_POOL_HPP
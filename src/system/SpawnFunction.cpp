@@ -5,21 +5,30 @@
 */
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <mutex>
+#include <sstream>
+#include <time.h>
+#include <tuple>
 #include <utility>
 
 #include <nosv.h>
 
 #include "SpawnFunction.hpp"
+#include "hardware/CPUContext.hpp"
 #include "instrument/OVNIInstrumentation.hpp"
 #include "system/TaskCreation.hpp"
 #include "tasks/TaskInfo.hpp"
 
 //! Static members
 std::atomic<unsigned int> SpawnFunction::_pendingSpawnedFunctions(0);
-std::map<SpawnFunction::task_info_key_t, nanos6_task_info_t> SpawnFunction::_spawnedFunctionInfos;
+std::map<SpawnFunction::task_info_key_t, SpawnFunction::spawned_function_info_t> SpawnFunction::_spawnedFunctionInfos;
 SpinLock SpawnFunction::_spawnedFunctionInfosLock;
+std::atomic<SpawnFunction::task_info_cache_entry_t *> SpawnFunction::_taskInfoCache[SpawnFunction::TASK_INFO_CACHE_SIZE];
 nanos6_task_invocation_info_t SpawnFunction::_spawnedFunctionInvocationInfo = { "Spawned from external code" };
+std::atomic<nosv_task_t> SpawnFunction::_shutdownWaiter(nullptr);
+EnvironmentVariable<uint64_t> SpawnFunction::_shutdownTimeout("NODES_SHUTDOWN_TIMEOUT", 0);
 
 //! Args block of spawned functions
 struct SpawnedFunctionArgsBlock {
@@ -27,16 +36,31 @@ struct SpawnedFunctionArgsBlock {
 	void *_args;
 	SpawnFunction::function_t _completionCallback;
 	void *_completionArgs;
+	SpawnFunction::function_t _argsDestructor;
 
 	SpawnedFunctionArgsBlock() :
 		_function(nullptr),
 		_args(nullptr),
 		_completionCallback(nullptr),
-		_completionArgs(nullptr)
+		_completionArgs(nullptr),
+		_argsDestructor(nullptr)
 	{
 	}
 };
 
+//! Inline args of spawned functions are placed right after the args block
+static constexpr size_t SPAWNED_FUNCTION_ARGS_BLOCK_SIZE =
+	(sizeof(SpawnedFunctionArgsBlock) + alignof(void *) - 1) & ~(alignof(void *) - 1);
+
+static inline size_t hashTaskInfoKey(SpawnFunction::function_t function, char const *label)
+{
+	uintptr_t key = ((uintptr_t) function) ^ (((uintptr_t) label) * 0x9E3779B97F4A7C15ULL);
+	key ^= (key >> 29);
+	key *= 0xBF58476D1CE4E5B9ULL;
+	key ^= (key >> 32);
+	return (size_t) key;
+}
+
 void nanos6_spawn_function(
 	void (*function)(void *),
 	void *args,
@@ -65,15 +89,103 @@ void SpawnFunction::spawnedFunctionDestructor(void *args)
 	if (argsBlock->_completionCallback != nullptr) {
 		argsBlock->_completionCallback(argsBlock->_completionArgs);
 	}
+
+	// Destroy the inline args if present
+	if (argsBlock->_argsDestructor != nullptr) {
+		argsBlock->_argsDestructor(argsBlock->_args);
+	}
 }
 
-void SpawnFunction::spawnFunction(
+nanos6_task_info_t *SpawnFunction::getTaskInfo(function_t function, char const *label)
+{
+	// Fast path: look up the cache without locking. The cache is keyed by the address of
+	// the label, so the contents are checked too in case the label storage was reused
+	const size_t hash = hashTaskInfoKey(function, label);
+	for (size_t probe = 0; probe < TASK_INFO_CACHE_PROBES; ++probe) {
+		size_t slot = (hash + probe) & (TASK_INFO_CACHE_SIZE - 1);
+		task_info_cache_entry_t *entry = _taskInfoCache[slot].load(std::memory_order_acquire);
+		if (entry == nullptr)
+			break;
+
+		if (entry->_function == function && entry->_label == label) {
+			char const *cachedLabel = entry->_taskInfo->implementations[0].task_type_label;
+			if (strcmp(cachedLabel, (label != nullptr ? label : "")) == 0)
+				return entry->_taskInfo;
+		}
+	}
+
+	nanos6_task_info_t *taskInfo = nullptr;
+	task_info_key_t taskInfoKey(function, (label != nullptr ? label : ""));
+
+	std::lock_guard<SpinLock> guard(_spawnedFunctionInfosLock);
+	auto itAndBool = _spawnedFunctionInfos.emplace(
+		std::piecewise_construct, std::forward_as_tuple(taskInfoKey), std::forward_as_tuple()
+	);
+	auto it = itAndBool.first;
+	taskInfo = &(it->second._taskInfo);
+
+	if (itAndBool.second) {
+		// Ensure non-explicitely initialized fields are zeroed
+		memset(taskInfo, 0, sizeof(nanos6_task_info_t));
+
+		// New task info
+		taskInfo->implementations = (nanos6_task_implementation_info_t *)
+			malloc(sizeof(nanos6_task_implementation_info_t));
+		assert(taskInfo->implementations != nullptr);
+
+		taskInfo->implementation_count = 1;
+		taskInfo->implementations[0].run = SpawnFunction::spawnedFunctionWrapper;
+		taskInfo->implementations[0].device_type_id = nanos6_device_t::nanos6_host_device;
+		taskInfo->register_depinfo = nullptr;
+
+		// The completion callback will be called when the task is destroyed
+		taskInfo->destroy_args_block = SpawnFunction::spawnedFunctionDestructor;
+
+		// Use a copy since we do not know the actual lifetime of label
+		taskInfo->implementations[0].task_type_label = it->first.second.c_str();
+		taskInfo->implementations[0].declaration_source = "Spawned Task";
+		taskInfo->implementations[0].get_constraints = nullptr;
+
+		taskInfo->coro_handle_idx = -1;
+
+		// NOTE: Since NODES doesn't know about "TaskTypes", we create a nOS-V
+		// type regardless of labels and declaration sources. Thus for two
+		// identical labels, we will have two separate types in nOS-V.
+		// The registration can cause a data-race, so it must be inside this
+		// block as it is protected by a lock
+		// Register the new task info
+		TaskInfo::registerTaskInfo(taskInfo);
+	}
+
+	// Publish the task info in the first free slot of the cache. If all the probed slots
+	// are taken, the next lookups of this key will simply go through the map
+	for (size_t probe = 0; probe < TASK_INFO_CACHE_PROBES; ++probe) {
+		size_t slot = (hash + probe) & (TASK_INFO_CACHE_SIZE - 1);
+		task_info_cache_entry_t *entry = _taskInfoCache[slot].load(std::memory_order_relaxed);
+		if (entry == nullptr) {
+			entry = new task_info_cache_entry_t{function, label, taskInfo};
+			_taskInfoCache[slot].store(entry, std::memory_order_release);
+			break;
+		} else if (entry->_function == function && entry->_label == label) {
+			// The label storage was reused for a different label. Replacing the entry is
+			// not safe while other threads may be reading it, so keep the old one
+			break;
+		}
+	}
+
+	return taskInfo;
+}
+
+void *SpawnFunction::createSpawnedFunction(
 	function_t function,
 	void *args,
 	function_t completionCallback,
 	void *completionArgs,
+	function_t argsDestructor,
 	char const *label,
-	bool fromUserCode
+	bool fromUserCode,
+	size_t inlineArgsSize,
+	void **inlineArgs
 ) {
 	Instrument::enterSpawnFunction();
 
@@ -83,73 +195,135 @@ void SpawnFunction::spawnFunction(
 		_pendingSpawnedFunctions++;
 	}
 
-	nanos6_task_info_t *taskInfo = nullptr;
-	{
-		task_info_key_t taskInfoKey(function, (label != nullptr ? label : ""));
-
-		std::lock_guard<SpinLock> guard(_spawnedFunctionInfosLock);
-		auto itAndBool = _spawnedFunctionInfos.emplace(
-			std::make_pair(taskInfoKey, nanos6_task_info_t())
-		);
-		auto it = itAndBool.first;
-		taskInfo = &(it->second);
-
-		if (itAndBool.second) {
-			// Ensure non-explicitely initialized fields are zeroed
-			memset(taskInfo, 0, sizeof(nanos6_task_info_t));
-
-			// New task info
-			taskInfo->implementations = (nanos6_task_implementation_info_t *)
-				malloc(sizeof(nanos6_task_implementation_info_t));
-			assert(taskInfo->implementations != nullptr);
-
-			taskInfo->implementation_count = 1;
-			taskInfo->implementations[0].run = SpawnFunction::spawnedFunctionWrapper;
-			taskInfo->implementations[0].device_type_id = nanos6_device_t::nanos6_host_device;
-			taskInfo->register_depinfo = nullptr;
-
-			// The completion callback will be called when the task is destroyed
-			taskInfo->destroy_args_block = SpawnFunction::spawnedFunctionDestructor;
-
-			// Use a copy since we do not know the actual lifetime of label
-			taskInfo->implementations[0].task_type_label = it->first.second.c_str();
-			taskInfo->implementations[0].declaration_source = "Spawned Task";
-			taskInfo->implementations[0].get_constraints = nullptr;
-
-			taskInfo->coro_handle_idx = -1;
-
-			// NOTE: Since NODES doesn't know about "TaskTypes", we create a nOS-V
-			// type regardless of labels and declaration sources. Thus for two
-			// identical labels, we will have two separate types in nOS-V.
-			// The registration can cause a data-race, so it must be inside this
-			// block as it is protected by a lock
-			// Register the new task info
-			TaskInfo::registerTaskInfo(taskInfo);
-		}
-	}
+	nanos6_task_info_t *taskInfo = getTaskInfo(function, label);
+	assert(taskInfo != nullptr);
+
+	// The pending functions of each type are only needed to report them when the shutdown
+	// times out, so the spawn path does not update a shared counter otherwise
+	if (isPendingCountEnabled())
+		getSpawnedFunctionInfo(taskInfo)->_pending.fetch_add(1, std::memory_order_relaxed);
 
 	// Create the task representing the spawned function
 	void *task = nullptr;
 	SpawnedFunctionArgsBlock *argsBlock = nullptr;
 	nanos6_create_task(
 		taskInfo, &_spawnedFunctionInvocationInfo, nullptr,
-		sizeof(SpawnedFunctionArgsBlock),
+		SPAWNED_FUNCTION_ARGS_BLOCK_SIZE + inlineArgsSize,
 		(void **) &argsBlock, &task, nanos6_waiting_task, 0
 	);
 	assert(task != nullptr);
 	assert(argsBlock != nullptr);
 
+	// The inline args, if any, are passed to both the function and the completion callback
+	if (inlineArgsSize > 0) {
+		assert(inlineArgs != nullptr);
+		args = ((char *) argsBlock) + SPAWNED_FUNCTION_ARGS_BLOCK_SIZE;
+		completionArgs = args;
+		*inlineArgs = args;
+	}
+
 	argsBlock->_function = function;
 	argsBlock->_args = args;
 	argsBlock->_completionCallback = completionCallback;
 	argsBlock->_completionArgs = completionArgs;
+	argsBlock->_argsDestructor = argsDestructor;
 
 	// Set the task as spawned
 	TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata((nosv_task_t) task);
 	taskMetadata->setSpawned(true);
 
+	return task;
+}
+
+void SpawnFunction::submitSpawnedFunction(void *task)
+{
+	assert(task != nullptr);
+
 	// Submit the task
 	TaskCreation::submitTask((nosv_task_t) task);
 
 	Instrument::exitSpawnFunction();
 }
+
+void SpawnFunction::spawnFunction(
+	function_t function,
+	void *args,
+	function_t completionCallback,
+	void *completionArgs,
+	char const *label,
+	bool fromUserCode
+) {
+	void *task = createSpawnedFunction(
+		function, args, completionCallback, completionArgs,
+		nullptr, label, fromUserCode, 0, nullptr
+	);
+
+	submitSpawnedFunction(task);
+}
+
+//! \brief Get the time of a monotonic clock in nanoseconds
+static inline uint64_t getMonotonicTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void SpawnFunction::dumpPendingSpawnedFunctions()
+{
+	std::ostringstream oss;
+	oss << _pendingSpawnedFunctions.load() << " spawned functions are still pending:";
+
+	std::lock_guard<SpinLock> guard(_spawnedFunctionInfosLock);
+	for (auto &spawned : _spawnedFunctionInfos) {
+		size_t pending = spawned.second._pending.load(std::memory_order_relaxed);
+		if (pending > 0) {
+			char const *label = spawned.first.second.c_str();
+			oss << std::endl << "\t" << pending << " x " << ((label[0] != '\0') ? label : "(unlabeled)");
+		}
+	}
+
+	ErrorHandler::warn(oss.str());
+}
+
+void SpawnFunction::waitForSpawnedFunctions()
+{
+	const uint64_t timeout = _shutdownTimeout.getValue();
+
+	if (timeout > 0) {
+		// With a deadline, sleep in short slices instead of waiting to be woken up. The slices
+		// may last more or less than requested, so the deadline is checked against the clock
+		const uint64_t sliceNs = 1000 * 1000;
+		const uint64_t deadlineNs = getMonotonicTime() + timeout * 1000 * 1000;
+		while (_pendingSpawnedFunctions.load() > 0) {
+			if (getMonotonicTime() >= deadlineNs) {
+				dumpPendingSpawnedFunctions();
+				ErrorHandler::fail("Spawned functions did not finish within NODES_SHUTDOWN_TIMEOUT (", timeout, " ms)");
+			}
+
+			uint64_t actualWaitTime;
+			if (int err = nosv_waitfor(sliceNs, &actualWaitTime))
+				ErrorHandler::fail("nosv_waitfor failed: ", nosv_get_error_string(err));
+
+			CPUContext::invalidate();
+		}
+		return;
+	}
+
+	while (_pendingSpawnedFunctions.load() > 0) {
+		nosv_task_t self = nosv_self();
+		assert(self != nullptr);
+
+		_shutdownWaiter.store(self);
+
+		// The last spawned function may have been disposed before publishing ourselves. In
+		// that case, withdraw unless the disposer already took us, since it will resubmit us
+		if (_pendingSpawnedFunctions.load() == 0 && _shutdownWaiter.exchange(nullptr) != nullptr)
+			break;
+
+		if (int err = nosv_pause(NOSV_PAUSE_NONE))
+			ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
+
+		CPUContext::invalidate();
+	}
+}
@@ -12,11 +12,18 @@
 #include <cstdlib>
 #include <functional>
 #include <map>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#include <nosv.h>
 
 #include <nodes/library-mode.h>
 #include <nodes/task-instantiation.h>
 
+#include "common/EnvironmentVariable.hpp"
+#include "common/ErrorHandler.hpp"
 #include "common/SpinLock.hpp"
 
 
@@ -34,15 +41,52 @@ private:
 	//! Key to identify spawned functions (user function and label)
 	typedef std::pair<function_t, std::string> task_info_key_t;
 
+	//! Task info of spawned functions along with the number of tasks that have not been disposed,
+	//! which is only counted when NODES_SHUTDOWN_TIMEOUT is set. The task info must be the first
+	//! field, since it is used to find the whole structure
+	struct spawned_function_info_t {
+		nanos6_task_info_t _taskInfo;
+		std::atomic<size_t> _pending;
+
+		spawned_function_info_t() :
+			_taskInfo(),
+			_pending(0)
+		{
+		}
+	};
+
 	//! Map storing the task infos of spawned function
-	static std::map<task_info_key_t, nanos6_task_info_t> _spawnedFunctionInfos;
+	static std::map<task_info_key_t, spawned_function_info_t> _spawnedFunctionInfos;
 
 	//! Spinlock to access the map of task infos
 	static SpinLock _spawnedFunctionInfosLock;
 
+	//! Entry of the cache of task infos, keyed by the addresses of the function and the label
+	struct task_info_cache_entry_t {
+		function_t _function;
+		char const *_label;
+		nanos6_task_info_t *_taskInfo;
+	};
+
+	//! Number of entries of the cache of task infos (must be a power of two)
+	static constexpr size_t TASK_INFO_CACHE_SIZE = 512;
+
+	//! Maximum number of entries inspected when looking up the cache of task infos
+	static constexpr size_t TASK_INFO_CACHE_PROBES = 8;
+
+	//! Cache of task infos, which is read without locking. Entries are only published while
+	//! holding the lock of the map of task infos, and are never removed until the shutdown
+	static std::atomic<task_info_cache_entry_t *> _taskInfoCache[TASK_INFO_CACHE_SIZE];
+
 	//! Common invocation info for spawned functions
 	static nanos6_task_invocation_info_t _spawnedFunctionInvocationInfo;
 
+	//! The task blocked at the shutdown until all spawned functions are disposed
+	static std::atomic<nosv_task_t> _shutdownWaiter;
+
+	//! Maximum time in milliseconds to wait for spawned functions at the shutdown (0 means no limit)
+	static EnvironmentVariable<uint64_t> _shutdownTimeout;
+
 private:
 
 	//! \brief Wrapper function called by spawned tasks
@@ -65,6 +109,58 @@ private:
 	//! \param[in,out] argsBlock A pointer to a block of data for the parameters
 	static void spawnedFunctionDestructor(void *args);
 
+	//! \brief Get the task info of a spawned function, creating it if needed
+	//!
+	//! \param[in] function The function to be spawned
+	//! \param[in] label An optional name for the function
+	static nanos6_task_info_t *getTaskInfo(function_t function, char const *label);
+
+	//! \brief Create the task of a spawned function without submitting it
+	//!
+	//! \param[in] function The function to be spawned
+	//! \param[in] args The parameter that is passed to the function
+	//! \param[in] completionCallback An optional function that will be called when the function finishes
+	//! \param[in] completionArgs The parameter that is passed to the completion callback
+	//! \param[in] argsDestructor An optional function that destroys the inline args after the completion callback
+	//! \param[in] label An optional name for the function
+	//! \param[in] fromUserCode Whether called from user code (i.e. nanos6_spawn_function)
+	//! \param[in] inlineArgsSize The size of the storage reserved after the args block of the task
+	//! \param[out] inlineArgs A pointer to the storage reserved after the args block of the task
+	//!
+	//! \returns The task of the spawned function
+	static void *createSpawnedFunction(
+		function_t function,
+		void *args,
+		function_t completionCallback,
+		void *completionArgs,
+		function_t argsDestructor,
+		char const *label,
+		bool fromUserCode,
+		size_t inlineArgsSize,
+		void **inlineArgs
+	);
+
+	//! \brief Submit the task of a spawned function
+	static void submitSpawnedFunction(void *task);
+
+	//! \brief Print the spawned functions that have not been disposed yet
+	static void dumpPendingSpawnedFunctions();
+
+	//! \brief Whether the pending spawned functions of each type are counted, which is only
+	//! needed to report them when the shutdown times out
+	static inline bool isPendingCountEnabled()
+	{
+		return (_shutdownTimeout.getValue() > 0);
+	}
+
+	static inline spawned_function_info_t *getSpawnedFunctionInfo(nanos6_task_info_t *taskInfo)
+	{
+		static_assert(std::is_standard_layout<spawned_function_info_t>::value,
+			"The task info must be reachable from the spawned function info");
+
+		return reinterpret_cast<spawned_function_info_t *>(taskInfo);
+	}
+
 public:
 
 	//! \brief Spawn a function asynchronously
@@ -84,11 +180,81 @@ public:
 		bool fromUserCode = false
 	);
 
+	//! \brief Spawn a function asynchronously, keeping its parameter inside the task
+	//!
+	//! The parameter is moved or copied into the args block of the task, so no extra allocation is needed.
+	//! Both the function and the completion callback receive a pointer to it, and it is destroyed
+	//! after the completion callback returns
+	//!
+	//! \param[in] function The function to be spawned
+	//! \param[in] completionCallback An optional function that will be called when the function finishes
+	//! \param[in] args The parameter that is passed to the function
+	//! \param[in] label An optional name for the function
+	//! \param[in] fromUserCode Whether called from user code (i.e. nanos6_spawn_function)
+	template <typename T>
+	static inline void spawnFunction(
+		function_t function,
+		function_t completionCallback,
+		T &&args,
+		char const *label,
+		bool fromUserCode = false
+	) {
+		// An lvalue argument makes T a reference, but the task keeps a copy of the value
+		using U = std::decay_t<T>;
+		static_assert(alignof(U) <= alignof(void *), "The inline args of spawned functions are pointer-aligned");
+
+		void *inlineArgs = nullptr;
+		void *task = createSpawnedFunction(
+			function, nullptr, completionCallback, nullptr,
+			[](void *storage) { ((U *) storage)->~U(); },
+			label, fromUserCode, sizeof(U), &inlineArgs
+		);
+		assert(inlineArgs != nullptr);
+
+		new (inlineArgs) U(std::forward<T>(args));
+
+		submitSpawnedFunction(task);
+	}
+
+	//! \brief Notify that the task of a spawned function has been disposed
+	//!
+	//! Wakes up the task waiting at the shutdown, if any, when it was the last pending one
+	//!
+	//! \param[in] taskInfo The task info of the spawned function
+	static inline void spawnedFunctionDisposed(nanos6_task_info_t *taskInfo)
+	{
+		assert(taskInfo != nullptr);
+
+		if (isPendingCountEnabled()) {
+			__attribute__((unused)) size_t pending = getSpawnedFunctionInfo(taskInfo)->_pending.fetch_sub(1, std::memory_order_relaxed);
+			assert(pending > 0);
+		}
+
+		if (--_pendingSpawnedFunctions == 0) {
+			nosv_task_t waiter = _shutdownWaiter.exchange(nullptr);
+			if (waiter != nullptr) {
+				if (int err = nosv_submit(waiter, NOSV_SUBMIT_UNLOCKED))
+					ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
+			}
+		}
+	}
+
+	//! \brief Block the calling task until all the spawned functions have been disposed
+	//!
+	//! If NODES_SHUTDOWN_TIMEOUT is set, the pending spawned functions are printed and the
+	//! execution is aborted when they do not finish in time
+	static void waitForSpawnedFunctions();
+
 	//! \brief Finalize spawned functions
 	static inline void shutdown()
 	{
-		for (auto spawned : _spawnedFunctionInfos) {
-			nanos6_task_info_t &taskInfo = spawned.second;
+		for (size_t i = 0; i < TASK_INFO_CACHE_SIZE; ++i) {
+			task_info_cache_entry_t *entry = _taskInfoCache[i].exchange(nullptr, std::memory_order_relaxed);
+			delete entry;
+		}
+
+		for (auto &spawned : _spawnedFunctionInfos) {
+			nanos6_task_info_t &taskInfo = spawned.second._taskInfo;
 			nanos6_task_implementation_info_t *implementations = taskInfo.implementations;
 			assert(implementations != nullptr);
 
@@ -14,6 +14,8 @@
 
 #include "common/ErrorHandler.hpp"
 #include "common/UserMutex.hpp"
+#include "hardware/CPUContext.hpp"
+#include "instrument/Statistics.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
@@ -34,6 +36,8 @@ extern "C" void nanos6_block_current_task(void *)
 
 	if (int err = nosv_pause(NOSV_PAUSE_NONE))
 		ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
+
+	CPUContext::invalidate();
 }
 
 extern "C" void nanos6_unblock_task(void *blocking_context)
@@ -55,6 +59,8 @@ extern "C" uint64_t nanos6_wait_for(uint64_t timeUs)
 	if (int err = nosv_waitfor(timeUs * 1000, &(actualWaitTime)))
 		ErrorHandler::fail("nosv_waitfor failed: ", nosv_get_error_string(err));
 
+	CPUContext::invalidate();
+
 	return actualWaitTime / (uint64_t) 1000;
 }
 
@@ -92,6 +98,8 @@ extern "C" void nanos6_user_lock(void **handlerPointer, char const *)
 		return;
 	}
 
+	Statistics::increment(Statistics::USER_MUTEX_CONTENTIONS);
+
 	TaskMetadata *currentTask = TaskMetadata::getCurrentTask();
 	assert(currentTask != nullptr);
 
@@ -104,6 +112,8 @@ extern "C" void nanos6_user_lock(void **handlerPointer, char const *)
 	if (int err = nosv_pause(NOSV_PAUSE_NONE))
 		ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
 
+	CPUContext::invalidate();
+
 	// This in combination with a release from other threads makes their changes visible to this one
 	std::atomic_thread_fence(std::memory_order_acquire);
 }
@@ -134,4 +144,6 @@ extern "C" void nanos6_yield(void)
 
 	if (int err = nosv_yield(NOSV_YIELD_NONE))
 		ErrorHandler::fail("nosv_yield failed: ", nosv_get_error_string(err));
+
+	CPUContext::invalidate();
 }
@@ -12,20 +12,73 @@
 #include <nodes/task-instantiation.h>
 
 #include "common/ErrorHandler.hpp"
+#include "hardware/HardwareInfo.hpp"
 #include "dependencies/discrete/CPUDependencyData.hpp"
 #include "dependencies/discrete/DataAccessRegistration.hpp"
 #include "dependencies/discrete/TaskDataAccesses.hpp"
 #include "dependencies/discrete/TaskDataAccessesInfo.hpp"
 #include "dependencies/discrete/taskiter/TaskGroupMetadata.hpp"
+#include "instrument/GraphRecorder.hpp"
 #include "instrument/OVNIInstrumentation.hpp"
+#include "instrument/Statistics.hpp"
 #include "memory/MemoryAllocator.hpp"
-#include "hardware/HardwareInfo.hpp"
+#include "hardware/CPUContext.hpp"
 #include "system/TaskCreation.hpp"
 #include "tasks/TaskiterMetadata.hpp"
 #include "tasks/TaskiterChildLoopMetadata.hpp"
 #include "tasks/TaskiterChildMetadata.hpp"
 #include "tasks/TaskloopMetadata.hpp"
 #include "tasks/TaskMetadata.hpp"
+#include "tasks/TaskTypeData.hpp"
+
+EnvironmentVariable<bool> TaskCreation::_inlineTasks("NODES_INLINE_TASKS", false);
+EnvironmentVariable<size_t> TaskCreation::_inlineQueueThreshold("NODES_INLINE_QUEUE_THRESHOLD", 4);
+EnvironmentVariable<uint64_t> TaskCreation::_inlineCostThreshold("NODES_INLINE_COST_THRESHOLD", 10000);
+EnvironmentVariable<size_t> TaskCreation::_finalDepthCutoff("NODES_FINAL_DEPTH_CUTOFF", 0);
+EnvironmentVariable<size_t> TaskCreation::_finalReadyCutoff("NODES_FINAL_READY_CUTOFF", 0);
+TaskCreation::queued_tasks_t *TaskCreation::_queuedTasks = nullptr;
+
+void TaskCreation::initialize()
+{
+	if (!_inlineTasks.getValue() && _finalReadyCutoff.getValue() == 0)
+		return;
+
+	size_t numCpus = HardwareInfo::getNumCpus();
+	_queuedTasks = new queued_tasks_t[numCpus];
+	for (size_t cpu = 0; cpu < numCpus; ++cpu)
+		_queuedTasks[cpu].store(0, std::memory_order_relaxed);
+}
+
+void TaskCreation::shutdown()
+{
+	delete[] _queuedTasks;
+	_queuedTasks = nullptr;
+}
+
+bool TaskCreation::mustRunInline(TaskMetadata *taskMetadata, nanos6_task_info_t *taskInfo, size_t cpuId)
+{
+	// Only plain tasks, since the creator becomes blocked until the task ends
+	TaskMetadata *parent = taskMetadata->getParent();
+	assert(parent != nullptr);
+
+	if (taskMetadata->isTaskloop() || taskMetadata->isTaskiter() || taskMetadata->isTaskiterChild()
+		|| parent->isTaskiterChild() || taskInfo->coro_handle_idx != -1)
+		return false;
+
+	// Keep submitting while the CPU does not have enough work queued
+	if (_queuedTasks[cpuId].load(std::memory_order_relaxed) < _inlineQueueThreshold.getValue())
+		return false;
+
+	// Children of final tasks are cheap by definition
+	uint64_t costThreshold = _inlineCostThreshold.getValue();
+	if (costThreshold == 0 || parent->isFinal())
+		return true;
+
+	// Otherwise, rely on the measured cost of the task type. Types that have not run yet
+	// are submitted, since they could be expensive
+	uint64_t cost = TaskTypeData::get(taskInfo)->getExecutionCost();
+	return (cost > 0 && cost <= costThreshold);
+}
 
 template <typename T>
 void TaskCreation::createTask(nanos6_task_info_t *taskInfo,
@@ -70,7 +123,7 @@ void TaskCreation::createTask(nanos6_task_info_t *taskInfo,
 	bool locallyAllocated = ((taskSize + sizeof(void *)) > NOSV_MAX_METADATA_SIZE);
 
 	// Create the nOS-V task
-	nosv_task_type_t tasktype = (nosv_task_type_t) taskInfo->task_type_data;
+	nosv_task_type_t tasktype = TaskTypeData::get(taskInfo)->getType();
 	assert(tasktype != nullptr);
 
 	nosv_task_t task;
@@ -85,21 +138,23 @@ void TaskCreation::createTask(nanos6_task_info_t *taskInfo,
 
 	// Since we won't know if the metadata returned by nOS-V is a memory region
 	// or a pointer that points to a locally allocated region, we always alloc
-	// extra space for a pointer that references the metadata's real region
-	// - If nOS-V can allocate the memory, the pointer will point to the memory
-	// allocated right next to it
-	// - If nOS-V can't allocate the memory, the pointer will point to a region
+	// extra space for a header word before the metadata's real region
+	// - If nOS-V can allocate the memory, the header is null and the metadata
+	// is placed right next to it
+	// - If nOS-V can't allocate the memory, the header points to a region
 	// of memory allocated by NODES
-	void **metadataPointer = (void **) nosv_get_task_metadata(task);
-	assert(metadataPointer != nullptr);
+	void **header = (void **) nosv_get_task_metadata(task);
+	assert(header != nullptr);
 
+	void *metadata;
 	if (locallyAllocated) {
-		*metadataPointer = MemoryAllocator::alloc(taskSize);
+		Statistics::increment(Statistics::LOCAL_METADATA_ALLOCATIONS);
+		metadata = MemoryAllocator::alloc(taskSize);
+		*header = metadata;
 	} else {
-		*metadataPointer = ((char *) metadataPointer + sizeof(void *));
+		metadata = (void *) (header + 1);
+		*header = nullptr;
 	}
-
-	void *metadata = *metadataPointer;
 	assert(metadata != nullptr);
 
 	if (!hasPreallocatedArgsBlock) {
@@ -115,6 +170,8 @@ void TaskCreation::createTask(nanos6_task_info_t *taskInfo,
 	// Assign the nOS-V task pointer for a future submit
 	*taskPointer = (void *) task;
 
+	Statistics::increment(Statistics::TASKS_CREATED);
+
 	Instrument::exitCreateTask();
 }
 
@@ -191,9 +248,18 @@ void nanos6_create_loop(
 		ErrorHandler::fail("Taskfor no longer supported");
 	}
 
+	// Choose the grainsize now, since the number of children depends on it
+	if (grainsize == 0) {
+		grainsize = TaskloopMetadata::chooseGrainsize(task_info, upper_bound - lower_bound);
+	}
+
 	// The compiler passes either the num deps of a single child or -1. However, the parent
-	// taskloop must register as many deps as num_deps * numTasks
-	if (num_deps != (size_t) -1) {
+	// taskloop must register as many deps as num_deps * numTasks. When the parent coalesces
+	// the accesses repeated across chunks, it registers them dynamically so that it only
+	// takes room for the distinct ones
+	if (TaskloopMetadata::coalescesDependencies(creatingInTaskiter())) {
+		num_deps = (size_t) -1;
+	} else if (num_deps != (size_t) -1) {
 		size_t numTasks = Taskloop::computeNumTasks((upper_bound - lower_bound), grainsize);
 		num_deps *= numTasks;
 	}
@@ -287,6 +353,8 @@ void TaskCreation::submitTask(nosv_task_t task)
 {
 	Instrument::enterSubmitTask();
 
+	Statistics::increment(Statistics::TASKS_SUBMITTED);
+
 	TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata(task);
 
 	nanos6_task_info_t *taskInfo = TaskMetadata::getTaskInfo(task);
@@ -309,15 +377,14 @@ void TaskCreation::submitTask(nosv_task_t task)
 		graph.addTask(taskMetadata);
 	}
 
+	// Record the task before its accesses, which are recorded while they are registered
+	if (GraphRecorder::isEnabled())
+		GraphRecorder::recordTask(taskMetadata, TaskTypeData::get(taskInfo)->getRecordId());
+
 	// Register the accesses of the task to check whether it is ready to be executed
 	bool ready = true;
 	if (taskInfo->register_depinfo != nullptr) {
-		int cpuId = nosv_get_current_logical_cpu();
-		if (cpuId < 0) {
-			ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
-		}
-
-		CPUDependencyData *cpuDepData = HardwareInfo::getCPUDependencyData(cpuId);
+		CPUDependencyData *cpuDepData = CPUContext::getDependencyData();
 		ready = DataAccessRegistration::registerTaskDataAccesses(taskMetadata, *cpuDepData);
 	}
 
@@ -330,6 +397,27 @@ void TaskCreation::submitTask(nosv_task_t task)
 	assert(parentTaskMetadata != nullptr || !isIf0);
 
 	if (ready && !isIf0) {
+		// Only the tasks created by the task running in this thread are considered, which
+		// also guarantees that the thread is a worker
+		if (_queuedTasks != nullptr && parentTaskMetadata != nullptr
+			&& parentTaskMetadata == TaskMetadata::getCurrentTask()) {
+			size_t cpuId = CPUContext::getCpuId();
+			if (_inlineTasks.getValue() && mustRunInline(taskMetadata, taskInfo, cpuId)) {
+				// Run the task in the creator, which keeps the same dependency handling
+				// through the end and completion callbacks
+				Statistics::increment(Statistics::TASKS_INLINED);
+
+				if (int err = nosv_submit(task, NOSV_SUBMIT_INLINE))
+					ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
+
+				Instrument::exitSubmitTask();
+				return;
+			}
+
+			_queuedTasks[cpuId].fetch_add(1, std::memory_order_relaxed);
+			taskMetadata->setQueuedCpu(cpuId);
+		}
+
 		// Submit the task to nOS-V if ready and not if0
 		if (int err = nosv_submit(task, NOSV_SUBMIT_NONE))
 			ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
@@ -353,9 +441,18 @@ void TaskCreation::submitTask(nosv_task_t task)
 
 			Instrument::enterWaitIf0();
 
+			const bool recordGraph = GraphRecorder::isEnabled();
+			if (recordGraph)
+				GraphRecorder::enterBlocking();
+
 			if (int err = nosv_pause(NOSV_PAUSE_NONE))
 				ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
 
+			if (recordGraph)
+				GraphRecorder::exitBlocking();
+
+			CPUContext::invalidate();
+
 			Instrument::exitWaitIf0();
 		}
 	}
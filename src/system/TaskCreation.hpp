@@ -7,13 +7,96 @@
 #ifndef TASK_CREATION_HPP
 #define TASK_CREATION_HPP
 
+#include <atomic>
+
 #include <nodes/task-instantiation.h>
 
 #include <nosv.h>
 
+#include "common/EnvironmentVariable.hpp"
+#include "common/Padding.hpp"
+#include "hardware/CPUContext.hpp"
+#include "instrument/Statistics.hpp"
+#include "tasks/TaskMetadata.hpp"
+
 class TaskCreation {
 
+	typedef Padded<std::atomic<size_t>> queued_tasks_t;
+
+	//! Whether ready tasks can be run inline by their creator when its CPU has enough
+	//! queued work
+	static EnvironmentVariable<bool> _inlineTasks;
+
+	//! Number of tasks queued by a CPU above which it starts running new tasks inline
+	static EnvironmentVariable<size_t> _inlineQueueThreshold;
+
+	//! Maximum measured cost (in nanoseconds) of the tasks that can be run inline, or 0
+	//! to run any ready task inline. By default, only tasks that take 10 us or less
+	static EnvironmentVariable<uint64_t> _inlineCostThreshold;
+
+	//! Nesting level from which tasks become final when they create children, or 0
+	static EnvironmentVariable<size_t> _finalDepthCutoff;
+
+	//! Number of tasks queued by a CPU from which tasks running on it become final when
+	//! they create children, or 0
+	static EnvironmentVariable<size_t> _finalReadyCutoff;
+
+	//! Tasks submitted to nOS-V by each CPU that have not started running yet. Only
+	//! counted when a policy needs it
+	static queued_tasks_t *_queuedTasks;
+
+	//! \brief Check whether a ready task should run inline in its creator instead of
+	//! being submitted to nOS-V. The creator must be the task running in this thread
+	static bool mustRunInline(TaskMetadata *taskMetadata, nanos6_task_info_t *taskInfo, size_t cpuId);
+
 public:
+	static void initialize();
+
+	static void shutdown();
+
+	//! \brief Check whether the children of a task should be run serially instead of
+	//! being created, and mark the task as final in that case. Only tasks without live
+	//! children can become final
+	//!
+	//! \param[in] taskMetadata The task running in this thread
+	//!
+	//! \returns Whether the task is final
+	static inline bool checkFinalCutoff(TaskMetadata *taskMetadata)
+	{
+		if (taskMetadata->isFinal())
+			return true;
+
+		// Taskiters need their children to build the graph
+		if (taskMetadata->isTaskiter() || taskMetadata->isTaskiterChild())
+			return false;
+
+		// The children of final tasks do not register their accesses, so a task with live
+		// children stays as it is. Otherwise, they could run before their earlier siblings
+		if (!taskMetadata->doesNotNeedToBlockForChildren())
+			return false;
+
+		size_t depthCutoff = _finalDepthCutoff.getValue();
+		size_t readyCutoff = _finalReadyCutoff.getValue();
+		if ((depthCutoff > 0 && taskMetadata->getNestingLevel() >= depthCutoff)
+			|| (readyCutoff > 0 && _queuedTasks[CPUContext::getCpuId()].load(std::memory_order_relaxed) >= readyCutoff)) {
+			taskMetadata->setFinal();
+			Statistics::increment(Statistics::TASKS_FINAL_CUTOFF);
+			return true;
+		}
+
+		return false;
+	}
+
+	//! \brief Notify that a task started running, so it no longer counts as queued
+	static inline void taskStarted(TaskMetadata *taskMetadata)
+	{
+		int queuedCpu = taskMetadata->getQueuedCpu();
+		if (queuedCpu >= 0) {
+			_queuedTasks[queuedCpu].fetch_sub(1, std::memory_order_relaxed);
+			taskMetadata->setQueuedCpu(-1);
+		}
+	}
+
 	//! \brief Create a NODES task
 	template <typename T>
 	static void createTask(
@@ -16,7 +16,7 @@
 #include "dependencies/discrete/CPUDependencyData.hpp"
 #include "dependencies/discrete/DataAccessRegistration.hpp"
 #include "dependencies/discrete/taskiter/TaskGroupMetadata.hpp"
-#include "hardware/HardwareInfo.hpp"
+#include "hardware/CPUContext.hpp"
 #include "memory/MemoryAllocator.hpp"
 #include "system/SpawnFunction.hpp"
 #include "tasks/TaskMetadata.hpp"
@@ -27,19 +27,16 @@ void TaskFinalization::taskEndedCallback(nosv_task_t task)
 	assert(task);
 
 	nosv_task_t lastTask = TaskMetadata::getLastTask();
+	TaskMetadata *lastTaskMetadata = TaskMetadata::getCurrentTask();
 	TaskMetadata::setLastTask(task);
 
 	TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata(task);
+	TaskMetadata::setCurrentTask(taskMetadata);
 
-	// Negative returned values mean the call failed, and the error is codified within
-	int cpuId = nosv_get_current_logical_cpu();
-	if (cpuId < 0) {
-		ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
-	}
-
-	DataAccessRegistration::combineTaskReductions(taskMetadata, cpuId);
+	DataAccessRegistration::combineTaskReductions(taskMetadata, CPUContext::getCpuId());
 
 	TaskMetadata::setLastTask(lastTask);
+	TaskMetadata::setCurrentTask(lastTaskMetadata);
 }
 
 void TaskFinalization::taskCompletedCallback(nosv_task_t task)
@@ -47,10 +44,12 @@ void TaskFinalization::taskCompletedCallback(nosv_task_t task)
 	assert(task);
 
 	nosv_task_t lastTask = TaskMetadata::getLastTask();
+	TaskMetadata *lastTaskMetadata = TaskMetadata::getCurrentTask();
 	TaskMetadata::setLastTask(task);
 
 	// Mark that the task has finished user code execution
 	TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata(task);
+	TaskMetadata::setCurrentTask(taskMetadata);
 	taskMetadata->markAsFinished();
 
 	// If the task has a wait clause, the release of dependencies must be
@@ -81,11 +80,7 @@ void TaskFinalization::taskCompletedCallback(nosv_task_t task)
 		if (isExternal) {
 			cpuDepData = new CPUDependencyData();
 		} else {
-			int cpuId = nosv_get_current_logical_cpu();
-			if (cpuId < 0) {
-				ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
-			}
-			cpuDepData = HardwareInfo::getCPUDependencyData(cpuId);
+			cpuDepData = CPUContext::getDependencyData();
 		}
 
 		bool finish = DataAccessRegistration::unregisterTaskDataAccesses(taskMetadata, *cpuDepData, lastTask != nullptr);
@@ -109,6 +104,7 @@ void TaskFinalization::taskCompletedCallback(nosv_task_t task)
 	}
 
 	TaskMetadata::setLastTask(lastTask);
+	TaskMetadata::setCurrentTask(lastTaskMetadata);
 }
 
 void TaskFinalization::taskFinished(TaskMetadata *task)
@@ -212,7 +208,7 @@ void TaskFinalization::disposeTask(TaskMetadata *task)
 		}
 
 		if (taskMetadata->isSpawned()) {
-			SpawnFunction::_pendingSpawnedFunctions--;
+			SpawnFunction::spawnedFunctionDisposed(taskInfo);
 		}
 
 		// Fetch the handle now as the metadata may get deleted
@@ -10,8 +10,10 @@
 
 #include "common/ErrorHandler.hpp"
 #include "dependencies/discrete/DataAccessRegistration.hpp"
-#include "hardware/HardwareInfo.hpp"
+#include "hardware/CPUContext.hpp"
+#include "instrument/GraphRecorder.hpp"
 #include "instrument/OVNIInstrumentation.hpp"
+#include "instrument/Statistics.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
@@ -24,8 +26,16 @@ extern "C" void nanos6_taskwait(char const */*invocationSource*/)
 
 	// Retreive the task's metadata
 	TaskMetadata *taskMetadata = TaskMetadata::getCurrentTask();
+
+	// The taskwait is recorded even if it does not block, since it may block when replayed
+	const bool recordGraph = GraphRecorder::isEnabled();
+	if (recordGraph)
+		GraphRecorder::recordTaskwait(taskMetadata);
+
 	if (taskMetadata->doesNotNeedToBlockForChildren()) {
 		std::atomic_thread_fence(std::memory_order_acquire);
+		if (recordGraph)
+			GraphRecorder::exitBlocking();
 		Instrument::exitTaskWait();
 		return;
 	}
@@ -42,8 +52,12 @@ extern "C" void nanos6_taskwait(char const */*invocationSource*/)
 	//   2. At any time the condition of the taskwait can become true
 	//   3. The task responsible for that change will re-queue the parent
 	if (!done) {
+		Statistics::increment(Statistics::TASKWAIT_BLOCKS);
+
 		if (int err = nosv_pause(NOSV_PAUSE_NONE))
 			ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
+
+		CPUContext::invalidate();
 	}
 
 	std::atomic_thread_fence(std::memory_order_acquire);
@@ -53,5 +67,88 @@ extern "C" void nanos6_taskwait(char const */*invocationSource*/)
 
 	DataAccessRegistration::handleExitTaskwait(taskMetadata);
 
+	if (recordGraph)
+		GraphRecorder::exitBlocking();
+
+	Instrument::exitTaskWait();
+}
+
+//! \brief Block the control flow of the current task until the children accessing a region are done
+//!
+//! \param[in] start The first address of the region
+//! \param[in] length The length of the region
+//! \param[in] accessType READ_ACCESS_TYPE to wait only for the writers, READWRITE_ACCESS_TYPE to wait for all
+//! \param[in] invocationSource A string that identifies the source code location of the invocation
+static inline void taskwaitOnRegion(void *start, size_t length, DataAccessType accessType, char const *invocationSource)
+{
+	TaskMetadata *taskMetadata = TaskMetadata::getCurrentTask();
+
+	// Taskiter children are only linked through their accesses on the first iteration, so
+	// fall back to a full taskwait for them
+	if (taskMetadata->isTaskiter() || taskMetadata->isTaskiterChild()) {
+		nanos6_taskwait(invocationSource);
+		return;
+	}
+
+	// Child accesses are found by their start address, so the region can only be waited for
+	// on its own if the children accessing part of it do so from the same address
+	if (!DataAccessRegistration::isTaskwaitRegionExact(taskMetadata, start, length)) {
+		nanos6_taskwait(invocationSource);
+		return;
+	}
+
+	Instrument::enterTaskWait();
+
+	// Taskwaits on dependencies are recorded as full taskwaits
+	const bool recordGraph = GraphRecorder::isEnabled();
+	if (recordGraph)
+		GraphRecorder::recordTaskwait(taskMetadata);
+
+	if (taskMetadata->doesNotNeedToBlockForChildren()) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (recordGraph)
+			GraphRecorder::exitBlocking();
+		Instrument::exitTaskWait();
+		return;
+	}
+
+	CPUDependencyData *cpuDepData = CPUContext::getDependencyData();
+
+	// ready == false:
+	//   1. The fragment is linked after the children accessing the region
+	//   2. At any time it can become satisfied
+	//   3. The task releasing the last predecessor of the fragment will re-queue this task
+	bool ready = DataAccessRegistration::registerTaskwaitFragment(
+		taskMetadata, start, length, accessType, *cpuDepData);
+
+	if (!ready) {
+		Statistics::increment(Statistics::TASKWAIT_BLOCKS);
+
+		if (int err = nosv_pause(NOSV_PAUSE_NONE))
+			ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
+
+		CPUContext::invalidate();
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (recordGraph)
+		GraphRecorder::exitBlocking();
+
 	Instrument::exitTaskWait();
 }
+
+extern "C" void nanos6_taskwait_in(void *start, size_t length, char const *invocationSource)
+{
+	taskwaitOnRegion(start, length, READ_ACCESS_TYPE, invocationSource);
+}
+
+extern "C" void nanos6_taskwait_out(void *start, size_t length, char const *invocationSource)
+{
+	taskwaitOnRegion(start, length, READWRITE_ACCESS_TYPE, invocationSource);
+}
+
+extern "C" void nanos6_taskwait_inout(void *start, size_t length, char const *invocationSource)
+{
+	taskwaitOnRegion(start, length, READWRITE_ACCESS_TYPE, invocationSource);
+}
@@ -10,6 +10,7 @@
 
 #include <nodes/final.h>
 
+#include "system/TaskCreation.hpp"
 #include "tasks/TaskMetadata.hpp"
 
 
@@ -17,12 +18,12 @@ extern "C" signed int nanos6_in_final(void)
 {
 	TaskMetadata *taskMetadata = TaskMetadata::getCurrentTask();
 	assert(taskMetadata != nullptr);
-	return taskMetadata->isFinal();
+	return TaskCreation::checkFinalCutoff(taskMetadata);
 }
 
 extern "C" signed int nanos6_in_serial_context(void)
 {
 	TaskMetadata *taskMetadata = TaskMetadata::getCurrentTask();
 	assert(taskMetadata != nullptr);
-	return taskMetadata->isFinal() || taskMetadata->isIf0();
+	return TaskCreation::checkFinalCutoff(taskMetadata) || taskMetadata->isIf0();
 }
@@ -10,11 +10,12 @@
 #include "common/ErrorHandler.hpp"
 
 
-std::vector<nosv_task_type_t> TaskInfo::_taskTypes;
+std::vector<TaskTypeData *> TaskInfo::_taskTypes;
 std::vector<nanos6_task_info_t *> TaskInfo::_taskInfos;
 SpinLock TaskInfo::_lock;
 bool TaskInfo::_initialized;
 size_t TaskInfo::unlabeledTaskInfos = 0;
+EnvironmentVariable<bool> TaskInfo::_costTracking("NODES_TASK_COST_TRACKING", false);
 
 void TaskInfo::registerTaskInfo(nanos6_task_info_t *taskInfo)
 {
@@ -40,8 +41,11 @@ void TaskInfo::shutdown()
 {
 	_lock.lock();
 	for (size_t i = 0; i < _taskTypes.size(); ++i) {
-		if (int err = nosv_type_destroy(_taskTypes[i], NOSV_TYPE_DESTROY_NONE))
+		if (int err = nosv_type_destroy(_taskTypes[i]->getType(), NOSV_TYPE_DESTROY_NONE))
 			ErrorHandler::fail("nosv_type_destroy failed: ", nosv_get_error_string(err));
+
+		delete _taskTypes[i];
 	}
+	_taskTypes.clear();
 	_lock.unlock();
 }
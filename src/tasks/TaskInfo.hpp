@@ -21,23 +21,29 @@
 #include <nodes/task-instantiation.h>
 
 #include "common/Chrono.hpp"
+#include "common/EnvironmentVariable.hpp"
 #include "common/ErrorHandler.hpp"
 #include "common/SpinLock.hpp"
 #include "dependencies/SymbolTranslation.hpp"
 #include "dependencies/discrete/DataAccessRegistration.hpp"
+#include "hardware/CPUContext.hpp"
+#include "instrument/GraphRecorder.hpp"
+#include "instrument/OVNIInstrumentation.hpp"
 #include "memory/MemoryAllocator.hpp"
+#include "system/TaskCreation.hpp"
 #include "system/TaskFinalization.hpp"
 #include "tasks/TaskiterMetadata.hpp"
 #include "tasks/TaskloopMetadata.hpp"
 #include "tasks/TaskMetadata.hpp"
+#include "tasks/TaskTypeData.hpp"
 
 
 class TaskInfo {
 
 private:
 
-	//! A vector with nOS-V tasktype info pointers
-	static std::vector<nosv_task_type_t> _taskTypes;
+	//! A vector with the data of the task types, including their nOS-V types
+	static std::vector<TaskTypeData *> _taskTypes;
 
 	//! A vector of unregistered nanos6 task infos to register after init
 	static std::vector<nanos6_task_info_t *> _taskInfos;
@@ -51,6 +57,36 @@ private:
 	// Global number of unlabeled task infos
 	static size_t unlabeledTaskInfos;
 
+	//! Whether to measure the execution time of tasks and report it (in nanoseconds) as
+	//! their cost when the compiler does not provide one
+	static EnvironmentVariable<bool> _costTracking;
+
+	//! \brief Run a chunk of a taskloop, measuring its cost per iteration if needed
+	static inline void runTaskloopChunk(
+		nanos6_task_info_t *taskInfo,
+		void *argsBlock,
+		TaskloopMetadata::bounds_t &bounds,
+		nanos6_address_translation_entry_t *translationTable
+	) {
+		if (!TaskloopMetadata::isAdaptiveGrainsizeEnabled()) {
+			taskInfo->implementations->run(argsBlock, &bounds, translationTable);
+			return;
+		}
+
+		Chrono chrono;
+		chrono.start();
+		taskInfo->implementations->run(argsBlock, &bounds, translationTable);
+		chrono.stop();
+
+		double elapsed = chrono;
+
+		// Intervals discarded by the chronometer are not accounted either
+		size_t iterations = bounds.upper_bound - bounds.lower_bound;
+		if (iterations > 0 && elapsed > 0.0) {
+			TaskTypeData::get(taskInfo)->recordIterationCost(elapsed, iterations);
+		}
+	}
+
 public:
 
 	//! \brief Run wrapper for task types
@@ -59,6 +95,7 @@ public:
 		assert(task != nullptr);
 
 		nosv_task_t lastTask = TaskMetadata::getLastTask();
+		TaskMetadata *lastTaskMetadata = TaskMetadata::getCurrentTask();
 		TaskMetadata::setLastTask(task);
 
 		nanos6_task_info_t *taskInfo = TaskMetadata::getTaskInfo(task);
@@ -66,17 +103,34 @@ public:
 		assert(taskInfo->implementation_count == 1);
 		assert(taskInfo->implementations != nullptr);
 
+		// The thread may have moved to another CPU since it ran its last task
+		CPUContext::taskStarted();
+
 		TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata(task);
+		TaskMetadata::setCurrentTask(taskMetadata);
+		TaskCreation::taskStarted(taskMetadata);
+
+		const char *label = TaskTypeData::get(taskInfo)->getLabel();
+		Instrument::startTask(label);
+
 		Chrono chrono;
 		if (taskMetadata->isTaskiterChild())
 			chrono.start();
 
+		// Taskloop sources only create their children, so they would skew the estimation
+		const bool trackCost = _costTracking.getValue() && !taskMetadata->isTaskloopSource();
+		Chrono costChrono;
+		if (trackCost)
+			costChrono.start();
+
+		const bool recordGraph = GraphRecorder::isEnabled();
+		GraphRecorder::task_timer_t previousTimer;
+		if (recordGraph)
+			previousTimer = GraphRecorder::taskStarted();
+
 		if (taskMetadata->hasCode()) {
 			size_t tableSize = 0;
-			int cpuId = nosv_get_current_logical_cpu();
-			if (cpuId < 0) {
-				ErrorHandler::fail("nosv_get_current_logical_cpu failed: ", nosv_get_error_string(cpuId));
-			}
+			size_t cpuId = CPUContext::getCpuId();
 
 			nanos6_address_translation_entry_t stackTranslationTable[SymbolTranslation::MAX_STACK_SYMBOLS];
 			nanos6_address_translation_entry_t *translationTable = SymbolTranslation::generateTranslationTable(
@@ -88,15 +142,18 @@ public:
 
 			if (taskMetadata->isTaskloop()) {
 				TaskloopMetadata *taskloopMetadata = (TaskloopMetadata *) taskMetadata;
-				if (!taskloopMetadata->isTaskloopSource()) {
-					taskInfo->implementations->run(
-						taskloopMetadata->getArgsBlock(),
-						&(taskloopMetadata->getBounds()),
-						translationTable
-					);
-				} else {
-					if (!isTaskiterChild)
-						taskloopMetadata->generateChildTasks();
+				if (taskloopMetadata->isTaskloopSource() && !isTaskiterChild)
+					taskloopMetadata->generateChildTasks();
+
+				TaskloopMetadata *scheduler = taskloopMetadata->getChunkScheduler();
+				if (scheduler != nullptr) {
+					// Run chunks until the iterations of the source run out
+					TaskloopMetadata::bounds_t chunkBounds = taskloopMetadata->getBounds();
+					while (scheduler->acquireChunk(chunkBounds)) {
+						runTaskloopChunk(taskInfo, taskloopMetadata->getArgsBlock(), chunkBounds, translationTable);
+					}
+				} else if (!taskloopMetadata->isTaskloopSource()) {
+					runTaskloopChunk(taskInfo, taskloopMetadata->getArgsBlock(), taskloopMetadata->getBounds(), translationTable);
 				}
 			} else if (taskMetadata->isTaskiter()) {
 				TaskiterMetadata *taskiterMetadata = (TaskiterMetadata *)taskMetadata;
@@ -156,16 +213,22 @@ public:
 			}
 		}
 
+		if (trackCost) {
+			costChrono.stop();
+
+			// Discard the measurement if the task migrated to a core with a counter behind
+			if (costChrono.getAccumulated() > 0)
+				TaskTypeData::get(taskInfo)->recordExecutionCost(costChrono.getAccumulated());
+		}
+
+		if (recordGraph)
+			GraphRecorder::taskEnded(taskMetadata, previousTimer);
+
 		if (taskMetadata->isTaskiterChild()) {
 			chrono.stop();
 
-			int cpuId = nosv_get_current_system_cpu();
-			if (cpuId < 0) {
-				ErrorHandler::fail("nosv_get_current_system_cpu failed: ", nosv_get_error_string(cpuId));
-			}
-
-			taskMetadata->setElapsedTime(chrono);
-			taskMetadata->setLastExecutionCore(cpuId);
+			taskMetadata->setElapsedTime(chrono.getAccumulated());
+			taskMetadata->setLastExecutionCore(CPUContext::getSystemCpuId());
 		}
 
 		if (!taskMetadata->isIf0Inlined()) {
@@ -177,7 +240,10 @@ public:
 				ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
 		}
 
+		Instrument::endTask(label);
+
 		TaskMetadata::setLastTask(lastTask);
+		TaskMetadata::setCurrentTask(lastTaskMetadata);
 	}
 
 	//! \brief Initialize the TaskInfo manager after the runtime has been initialized
@@ -211,6 +277,13 @@ public:
 					return constraints.cost;
 				}
 			}
+
+			// Otherwise, use the measured execution time of the type if available
+			if (_costTracking.getValue() && taskInfo->task_type_data != nullptr) {
+				uint64_t cost = TaskTypeData::get(taskInfo)->getExecutionCost();
+				if (cost > 0)
+					return cost;
+			}
 		}
 
 		return 1;
@@ -252,10 +325,12 @@ public:
 			ErrorHandler::fail("nosv_type_init failed: ", nosv_get_error_string(err));
 
 		// Link the taskinfo to the task type
-		taskInfo->task_type_data = (void *) type;
+		TaskTypeData *typeData = new TaskTypeData(type, label);
+		typeData->setRecordId(GraphRecorder::recordType(label));
+		taskInfo->task_type_data = (void *) typeData;
 
 		// Save the task type to destroy during the finalization
-		_taskTypes.push_back(type);
+		_taskTypes.push_back(typeData);
 
 		return type;
 	}
@@ -7,3 +7,4 @@
 #include "TaskMetadata.hpp"
 
 thread_local nosv_task_t TaskMetadata::_lastTask;
+thread_local TaskMetadata *TaskMetadata::_currentTask;
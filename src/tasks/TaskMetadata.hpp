@@ -15,6 +15,7 @@
 #include <nosv.h>
 #include <nosv/affinity.h>
 
+#include "common/SpinLock.hpp"
 #include "dependencies/discrete/TaskDataAccesses.hpp"
 
 #define DATA_ALIGNMENT_SIZE sizeof(void *)
@@ -96,12 +97,21 @@ private:
 	//! Iteration count
 	size_t _iterationCount;
 
-	//! Elapsed time
+	//! Elapsed time of the last execution in nanoseconds
 	uint64_t _elapsedTime;
 
 	//! Last core where the task was executed
 	int _lastExecutionCore;
 
+	//! CPU that submitted the task to nOS-V and counts it as queued, or -1 if none
+	int _queuedCpu;
+
+	//! Identifier of the task in the recorded task graph, or 0 if it is not recorded
+	uint64_t _recordId;
+
+	//! Number of ancestors of the task, not counting the main task
+	size_t _nestingLevel;
+
 	//! Delayed priority setting
 	int _delayedPriority;
 
@@ -120,6 +130,10 @@ private:
 	//! Pointer to the last task in the run stack
 	static thread_local nosv_task_t _lastTask;
 
+	//! Metadata of the task that the thread is running, or nullptr if it is not running a
+	//! task of the runtime. It is saved and restored along with the run stack
+	static thread_local TaskMetadata *_currentTask;
+
 	//! Whether a coroutine is using the frame allocated in the task metadata
 	bool _usingCoroutineFrame;
 
@@ -160,6 +174,9 @@ public:
 		_iterationCount(0),
 		_elapsedTime(0),
 		_lastExecutionCore(0),
+		_queuedCpu(-1),
+		_recordId(0),
+		_nestingLevel(0),
 		_delayedPriority(INT_MIN),
 		_priorityDelta(0),
 		_delayedAffinity(),
@@ -364,12 +381,10 @@ public:
 		// NOTE: It may happen that the task has no metadata (i.e. the attached task
 		// from Initialization.cpp)
 		// TODO: Assert that it can only be that task
-		TaskMetadata **parentMetadataPointer = (TaskMetadata **) nosv_get_task_metadata(parent);
-		if (parentMetadataPointer != nullptr) {
-			TaskMetadata *parentMetadata = *parentMetadataPointer;
-			assert(parentMetadata != nullptr);
-
+		TaskMetadata *parentMetadata = getTaskMetadata(parent);
+		if (parentMetadata != nullptr) {
 			_parent = parentMetadata;
+			_nestingLevel = parentMetadata->getNestingLevel() + 1;
 			parentMetadata->addChild();
 		}
 	}
@@ -473,6 +488,16 @@ public:
 		return _flags[final_flag];
 	}
 
+	inline void setFinal(bool value = true)
+	{
+		_flags[final_flag] = value;
+	}
+
+	inline size_t getNestingLevel() const
+	{
+		return _nestingLevel;
+	}
+
 	//! \brief Set or unset the taskloop flag
 	inline void setTaskloop(bool taskloopValue)
 	{
@@ -494,6 +519,20 @@ public:
 		return false;
 	}
 
+	//! \brief Whether this is a taskloop whose executors take chunks at run time, in which
+	//! case it registers strong accesses on their behalf
+	virtual inline bool isSelfSchedulingSource() const
+	{
+		return false;
+	}
+
+	//! \brief Get the lock that children must hold while inserting their accesses, which is only
+	//! needed when several tasks create children of this task concurrently
+	virtual inline SpinLock *getChildRegistrationLock()
+	{
+		return nullptr;
+	}
+
 	virtual inline void registerDependencies()
 	{
 		// Retreive the args block and taskinfo of the task
@@ -505,27 +544,27 @@ public:
 
 	static inline TaskMetadata *getTaskMetadata(nosv_task_t task)
 	{
-		// For info on the why of this double de-ref, check TaskCreation.cpp
-		TaskMetadata **taskMetadataPointer = (TaskMetadata **) nosv_get_task_metadata(task);
-		TaskMetadata *taskMetadata = nullptr;
-		if (taskMetadataPointer != nullptr) {
-			taskMetadata = *taskMetadataPointer;
-			assert(taskMetadata != nullptr);
-		}
+		// For info on the layout of the nOS-V metadata, check TaskCreation.cpp
+		void **header = (void **) nosv_get_task_metadata(task);
 
 		// TODO: Make sure that if we're returning nullptr it is due to the
 		// wrapped initialization in (Initialization.hpp)
-		return taskMetadata;
+		if (header == nullptr)
+			return nullptr;
+
+		// The header is only set when the metadata was allocated by NODES
+		void *locallyAllocated = *header;
+		if (locallyAllocated != nullptr)
+			return (TaskMetadata *) locallyAllocated;
+
+		return (TaskMetadata *) (header + 1);
 	}
 
+	//! \brief Get the metadata of the task running in the calling thread, which is
+	//! nullptr for the main task and for tasks from other nOS-V-enabled libraries
 	static inline TaskMetadata *getCurrentTask()
 	{
-		nosv_task_t task = nosv_self();
-
-		if (task && TaskMetadata::isLastTask(task))
-			return TaskMetadata::getTaskMetadata(task);
-		else // External task from other nosv-enabled library
-			return nullptr;
+		return _currentTask;
 	}
 
 	static inline nanos6_task_info_t *getTaskInfo(TaskMetadata *task)
@@ -667,6 +706,26 @@ public:
 		_group = group;
 	}
 
+	inline void setQueuedCpu(int cpuId)
+	{
+		_queuedCpu = cpuId;
+	}
+
+	inline int getQueuedCpu() const
+	{
+		return _queuedCpu;
+	}
+
+	inline void setRecordId(uint64_t recordId)
+	{
+		_recordId = recordId;
+	}
+
+	inline uint64_t getRecordId() const
+	{
+		return _recordId;
+	}
+
 	static inline void setLastTask(nosv_task_t task)
 	{
 		_lastTask = task;
@@ -682,6 +741,11 @@ public:
 		return _lastTask == task;
 	}
 
+	static inline void setCurrentTask(TaskMetadata *taskMetadata)
+	{
+		_currentTask = taskMetadata;
+	}
+
 	virtual ~TaskMetadata() = default;
 };
 
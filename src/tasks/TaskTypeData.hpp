@@ -0,0 +1,132 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef TASK_TYPE_DATA_HPP
+#define TASK_TYPE_DATA_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+#include <nosv.h>
+
+#include <nodes/task-instantiation.h>
+
+
+//! Runtime data shared by all the tasks of the same type, linked to the taskinfo
+//! through its task_type_data field
+class TaskTypeData {
+
+private:
+
+	//! The nOS-V type of the tasks
+	nosv_task_type_t _type;
+
+	//! The label of the type
+	std::string _label;
+
+	//! Identifier of the type in the recorded task graph, or 0 if it is not recorded
+	uint32_t _recordId;
+
+	//! Moving average of the cost of each taskloop iteration, in microseconds
+	//! (0 if no chunk has been measured yet)
+	std::atomic<double> _iterationCost;
+
+	//! Moving average of the execution time of the tasks, in nanoseconds
+	//! (0 if no task has been measured yet)
+	std::atomic<uint64_t> _executionCost;
+
+	//! Weight of the last measurement in the moving averages
+	static constexpr double EWMA_WEIGHT = 0.25;
+
+public:
+
+	inline TaskTypeData(nosv_task_type_t type, const std::string &label) :
+		_type(type),
+		_label(label),
+		_recordId(0),
+		_iterationCost(0.0),
+		_executionCost(0)
+	{
+	}
+
+	inline nosv_task_type_t getType() const
+	{
+		return _type;
+	}
+
+	inline const char *getLabel() const
+	{
+		return _label.c_str();
+	}
+
+	inline void setRecordId(uint32_t recordId)
+	{
+		_recordId = recordId;
+	}
+
+	inline uint32_t getRecordId() const
+	{
+		return _recordId;
+	}
+
+	//! \brief Get the average cost of each taskloop iteration in microseconds, or 0 if unknown
+	inline double getIterationCost() const
+	{
+		return _iterationCost.load(std::memory_order_relaxed);
+	}
+
+	//! \brief Account the execution of a taskloop chunk
+	//!
+	//! Concurrent updates may overwrite each other, which is fine for an estimation
+	//!
+	//! \param[in] elapsed The time taken by the chunk in microseconds
+	//! \param[in] iterations The number of iterations of the chunk
+	inline void recordIterationCost(double elapsed, size_t iterations)
+	{
+		assert(iterations > 0);
+
+		double sample = elapsed / (double) iterations;
+		double current = _iterationCost.load(std::memory_order_relaxed);
+		if (current > 0.0) {
+			sample = current + EWMA_WEIGHT * (sample - current);
+		}
+		_iterationCost.store(sample, std::memory_order_relaxed);
+	}
+
+	//! \brief Get the average execution time of the tasks, or 0 if unknown
+	inline uint64_t getExecutionCost() const
+	{
+		return _executionCost.load(std::memory_order_relaxed);
+	}
+
+	//! \brief Account the execution of a task
+	//!
+	//! Concurrent updates may overwrite each other, which is fine for an estimation
+	//!
+	//! \param[in] elapsed The time taken by the task in nanoseconds
+	inline void recordExecutionCost(uint64_t elapsed)
+	{
+		uint64_t current = _executionCost.load(std::memory_order_relaxed);
+		if (current > 0) {
+			elapsed = (uint64_t) ((double) current + EWMA_WEIGHT * ((double) elapsed - (double) current));
+		}
+		_executionCost.store(std::max(elapsed, (uint64_t) 1), std::memory_order_relaxed);
+	}
+
+	//! \brief Get the type data of a taskinfo that has been registered
+	static inline TaskTypeData *get(nanos6_task_info_t *taskInfo)
+	{
+		assert(taskInfo != nullptr);
+		assert(taskInfo->task_type_data != nullptr);
+
+		return (TaskTypeData *) taskInfo->task_type_data;
+	}
+};
+
+#endif // TASK_TYPE_DATA_HPP
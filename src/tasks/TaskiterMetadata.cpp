@@ -49,10 +49,8 @@ void TaskiterMetadata::cancel()
 
 	_stop = true;
 
-	nosv_task_t currentTask = nosv_self();
-	assert(currentTask != nullptr);
-
-	TaskMetadata *taskMetadata = TaskMetadata::getTaskMetadata(currentTask);
+	TaskMetadata *taskMetadata = TaskMetadata::getCurrentTask();
+	assert(taskMetadata != nullptr);
 	// We have to finish the groups also
 
 	std::unordered_set<TaskGroupMetadata *> groups;
@@ -4,8 +4,63 @@
 	Copyright (C) 2021 Barcelona Supercomputing Center (BSC)
 */
 
+#include <nosv.h>
+
 #include "TaskloopMetadata.hpp"
+#include "common/ErrorHandler.hpp"
+#include "hardware/CPUContext.hpp"
+#include "system/SpawnFunction.hpp"
+#include "tasks/TaskTypeData.hpp"
+
+EnvironmentVariable<size_t> TaskloopMetadata::_splitThreshold("NODES_TASKLOOP_SPLIT_THRESHOLD", 0);
+EnvironmentVariable<size_t> TaskloopMetadata::_splitFanout("NODES_TASKLOOP_SPLIT_FANOUT", 4);
+EnvironmentVariable<bool> TaskloopMetadata::_coalesceDependencies("NODES_TASKLOOP_COALESCE_DEPS", false);
+EnvironmentVariable<size_t> TaskloopMetadata::_targetChunkDuration("NODES_TASKLOOP_TARGET_CHUNK_US", 0);
+EnvironmentVariable<std::string> TaskloopMetadata::_scheduleName("NODES_TASKLOOP_SCHEDULE", "static");
+TaskloopMetadata::schedule_t TaskloopMetadata::_configuredSchedule = TaskloopMetadata::parseSchedule();
+
+//! Args of the spawned functions that generate taskloop children in parallel
+struct TaskloopGeneratorArgs {
+	TaskloopMetadata *_source;
+	size_t _firstChunk;
+	size_t _lastChunk;
+};
+
+TaskloopMetadata::schedule_t TaskloopMetadata::parseSchedule()
+{
+	std::string schedule = _scheduleName.getValue();
+	if (schedule == "static") {
+		return STATIC_SCHEDULE;
+	} else if (schedule == "dynamic") {
+		return DYNAMIC_SCHEDULE;
+	} else if (schedule == "guided") {
+		return GUIDED_SCHEDULE;
+	}
+
+	ErrorHandler::fail("Invalid value for NODES_TASKLOOP_SCHEDULE: ", schedule, ". Valid values are static, dynamic and guided");
+	return STATIC_SCHEDULE;
+}
 
+size_t TaskloopMetadata::chooseGrainsize(nanos6_task_info_t *taskInfo, size_t iterations)
+{
+	const size_t numCPUs = nosv_get_num_cpus();
+	const size_t defaultGrainsize = std::max(iterations / numCPUs, (size_t) 1);
+
+	if (!isAdaptiveGrainsizeEnabled())
+		return defaultGrainsize;
+
+	// Nothing measured yet for this taskloop
+	double iterationCost = TaskTypeData::get(taskInfo)->getIterationCost();
+	if (iterationCost <= 0.0)
+		return defaultGrainsize;
+
+	size_t grainsize = std::max((size_t) (_targetChunkDuration.getValue() / iterationCost), (size_t) 1);
+
+	// Keep enough chunks per CPU, even if they end up shorter than the target
+	size_t maxGrainsize = std::max(iterations / (numCPUs * ADAPTIVE_MIN_CHUNKS_PER_CPU), (size_t) 1);
+
+	return std::min(grainsize, maxGrainsize);
+}
 
 void TaskloopMetadata::registerDependencies()
 {
@@ -13,6 +68,9 @@ void TaskloopMetadata::registerDependencies()
 	nanos6_task_info_t *taskInfo = TaskMetadata::getTaskInfo(_task);
 	assert(taskInfo != nullptr);
 
+	// The accesses of each chunk are registered with their own bounds, since children find the
+	// access of the source by their start address. Accesses that do not depend on the loop
+	// variable have the same address in all chunks and are merged into a single one
 	if (isTaskloopSource()) {
 		bounds_t tmpBounds;
 		size_t numTasks = Taskloop::computeNumTasks(getIterationCount(), _bounds.grainsize);
@@ -35,14 +93,155 @@ void TaskloopMetadata::registerDependencies()
 			}
 		}
 		assert(tmpBounds.upper_bound == _bounds.upper_bound);
-	} else {
+	} else if (!_selfScheduled) {
 		taskInfo->register_depinfo(getArgsBlock(), (void *) &_bounds, this);
 	}
 }
 
 void TaskloopMetadata::generateChildTasks()
 {
-	while (getIterationCount() > 0) {
-		Taskloop::createTaskloopExecutor(this->getTaskHandle(), this, this->getBounds());
+	if (isSelfSchedulingSource()) {
+		// Executors do not have accesses, so the release of the accesses of the source
+		// must wait until all of them have run their chunks
+		setDelayedRelease(true);
+
+		// The default chunksize aims for several chunks per worker for load balance
+		size_t numCPUs = nosv_get_num_cpus();
+		size_t iterations = getIterationCount();
+		if (_bounds.chunksize == 0) {
+			_bounds.chunksize = std::max(iterations / (numCPUs * 8), (size_t) 1);
+		}
+
+		// About one worker per core, and the source itself is one of them
+		_numWorkers = std::max(std::min(numCPUs, MathSupport::ceil(iterations, _bounds.chunksize)), (size_t) 1);
+		_cursor.store(_bounds.lower_bound, std::memory_order_relaxed);
+
+		for (size_t w = 1; w < _numWorkers; ++w) {
+			Taskloop::createTaskloopExecutor(this, 0, 0);
+		}
+		return;
+	}
+
+	const size_t threshold = _splitThreshold.getValue();
+	const size_t numChunks = Taskloop::computeNumTasks(getIterationCount(), _bounds.grainsize);
+
+	// Generate the children serially unless there are many chunks. Taskiter children replay
+	// their creation order and if0 children would block the generators, so they are excluded
+	if (threshold == 0 || numChunks < threshold || isIf0() || isTaskiterChild()) {
+		while (getIterationCount() > 0) {
+			size_t lowerBound = _bounds.lower_bound;
+			size_t upperBound = std::min(lowerBound + _bounds.grainsize, _bounds.upper_bound);
+			_bounds.lower_bound = upperBound;
+
+			Taskloop::createTaskloopExecutor(this, lowerBound, upperBound);
+		}
+		return;
+	}
+
+	// The source counts as a generator until it finishes its own part
+	_parallelGeneration = true;
+	_pendingGenerators.store(1, std::memory_order_relaxed);
+
+	generateChunks(0, numChunks);
+
+	// The children must be registered before the source finishes, since it will release the
+	// accesses in its bottom map. The last generator resubmits the source if it has to wait
+	if (_pendingGenerators.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		if (int err = nosv_pause(NOSV_PAUSE_NONE))
+			ErrorHandler::fail("nosv_pause failed: ", nosv_get_error_string(err));
+
+		CPUContext::invalidate();
+	}
+	assert(_pendingGenerators.load(std::memory_order_relaxed) == 0);
+
+	_parallelGeneration = false;
+	_bounds.lower_bound = _bounds.upper_bound;
+}
+
+void TaskloopMetadata::generateChunks(size_t firstChunk, size_t lastChunk)
+{
+	const size_t threshold = _splitThreshold.getValue();
+	const size_t fanout = std::max(_splitFanout.getValue(), (size_t) 2);
+
+	// Keep the first part and hand the rest to other generators, until the range is small enough
+	while (lastChunk - firstChunk > threshold) {
+		size_t partSize = MathSupport::ceil(lastChunk - firstChunk, fanout);
+		size_t numParts = MathSupport::ceil(lastChunk - firstChunk, partSize);
+
+		_pendingGenerators.fetch_add(numParts - 1, std::memory_order_relaxed);
+
+		for (size_t part = 1; part < numParts; ++part) {
+			TaskloopGeneratorArgs args;
+			args._source = this;
+			args._firstChunk = firstChunk + part * partSize;
+			args._lastChunk = std::min(args._firstChunk + partSize, lastChunk);
+
+			SpawnFunction::spawnFunction(
+				TaskloopMetadata::generatorBody, nullptr,
+				std::move(args), "Taskloop generator", true
+			);
+		}
+
+		lastChunk = firstChunk + partSize;
+	}
+
+	for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+		size_t lowerBound = _bounds.lower_bound + chunk * _bounds.grainsize;
+		size_t upperBound = std::min(lowerBound + _bounds.grainsize, _bounds.upper_bound);
+
+		Taskloop::createTaskloopExecutor(this, lowerBound, upperBound);
+	}
+}
+
+bool TaskloopMetadata::acquireChunk(bounds_t &chunkBounds)
+{
+	assert(isSelfSchedulingSource());
+
+	const size_t upperBound = _bounds.upper_bound;
+	const size_t minChunk = _bounds.chunksize;
+	assert(minChunk > 0);
+
+	size_t lowerBound;
+	size_t chunk;
+	if (_schedule == GUIDED_SCHEDULE) {
+		// Hand out a share of the remaining iterations, but never less than the chunksize
+		lowerBound = _cursor.load(std::memory_order_relaxed);
+		do {
+			if (lowerBound >= upperBound)
+				return false;
+
+			size_t remaining = upperBound - lowerBound;
+			chunk = std::min(std::max(remaining / (2 * _numWorkers), minChunk), remaining);
+		} while (!_cursor.compare_exchange_weak(lowerBound, lowerBound + chunk, std::memory_order_relaxed));
+	} else {
+		lowerBound = _cursor.fetch_add(minChunk, std::memory_order_relaxed);
+		if (lowerBound >= upperBound)
+			return false;
+
+		chunk = std::min(minChunk, upperBound - lowerBound);
+	}
+
+	chunkBounds.lower_bound = lowerBound;
+	chunkBounds.upper_bound = lowerBound + chunk;
+	return true;
+}
+
+void TaskloopMetadata::finishGenerator()
+{
+	if (_pendingGenerators.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		if (int err = nosv_submit(getTaskHandle(), NOSV_SUBMIT_UNLOCKED))
+			ErrorHandler::fail("nosv_submit failed: ", nosv_get_error_string(err));
 	}
+}
+
+void TaskloopMetadata::generatorBody(void *args)
+{
+	TaskloopGeneratorArgs *generatorArgs = (TaskloopGeneratorArgs *) args;
+	assert(generatorArgs != nullptr);
+
+	TaskloopMetadata *source = generatorArgs->_source;
+	assert(source != nullptr);
+
+	source->generateChunks(generatorArgs->_firstChunk, generatorArgs->_lastChunk);
+	source->finishGenerator();
 }
\ No newline at end of file
@@ -7,14 +7,19 @@
 #ifndef TASKLOOP_METADATA_HPP
 #define TASKLOOP_METADATA_HPP
 
+#include <atomic>
 #include <cmath>
+#include <string>
 
 #include <nosv/hwinfo.h>
 
 #include <nodes/loop.h>
 
 #include "TaskMetadata.hpp"
+#include "common/EnvironmentVariable.hpp"
 #include "common/MathSupport.hpp"
+#include "common/SpinLock.hpp"
+#include "system/TaskCreation.hpp"
 
 
 class TaskloopMetadata : public TaskMetadata {
@@ -23,6 +28,16 @@ public:
 
 	typedef nanos6_loop_bounds_t bounds_t;
 
+	//! How the iterations of a taskloop are distributed among its executors
+	enum schedule_t {
+		//! One executor per grainsize chunk, each registering its own dependencies
+		STATIC_SCHEDULE = 0,
+		//! A few executors that take chunksize ranges from a shared cursor
+		DYNAMIC_SCHEDULE,
+		//! Like dynamic, but with chunks that decrease as the iterations run out
+		GUIDED_SCHEDULE
+	};
+
 private:
 
 	bounds_t _bounds;
@@ -37,6 +52,61 @@ private:
 	// numDeps, saving memory space and probably improving slightly the performance
 	size_t _maxChildDeps;
 
+	//! Whether the children are being created by several generator tasks at once
+	bool _parallelGeneration;
+
+	//! Serializes the insertion of children accesses while generating in parallel
+	SpinLock _childRegistrationLock;
+
+	//! Number of generators, including the source itself, that have not finished yet
+	std::atomic<size_t> _pendingGenerators;
+
+	//! Minimum number of chunks to generate the children in parallel (0 disables it)
+	static EnvironmentVariable<size_t> _splitThreshold;
+
+	//! Number of parts in which each generator splits its range of chunks
+	static EnvironmentVariable<size_t> _splitFanout;
+
+	//! Desired duration of each chunk in microseconds when the grainsize is chosen by the
+	//! runtime (0 disables the adaptive grainsize)
+	static EnvironmentVariable<size_t> _targetChunkDuration;
+
+	//! Minimum number of chunks per CPU that the adaptive grainsize keeps for load balance
+	static constexpr size_t ADAPTIVE_MIN_CHUNKS_PER_CPU = 2;
+
+	//! Whether sources register their accesses dynamically, merging the ones repeated across chunks
+	static EnvironmentVariable<bool> _coalesceDependencies;
+
+	//! The schedule of this source taskloop
+	schedule_t _schedule;
+
+	//! Whether this is an executor that takes its chunks from the source
+	bool _selfScheduled;
+
+	//! Number of tasks taking chunks from this source, including itself
+	size_t _numWorkers;
+
+	//! The first iteration not yet handed out to any worker
+	std::atomic<size_t> _cursor;
+
+	//! The schedule used by taskloops, taken from NODES_TASKLOOP_SCHEDULE
+	static EnvironmentVariable<std::string> _scheduleName;
+	static schedule_t _configuredSchedule;
+
+	static schedule_t parseSchedule();
+
+	//! \brief Create the executors of a range of chunks, handing parts of it to other generators
+	//!
+	//! \param[in] firstChunk The first chunk of the range
+	//! \param[in] lastChunk The chunk after the last one of the range
+	void generateChunks(size_t firstChunk, size_t lastChunk);
+
+	//! \brief Notify that a generator finished, waking up the source if it was the last one
+	void finishGenerator();
+
+	//! \brief Body of the spawned functions that generate children in parallel
+	static void generatorBody(void *args);
+
 public:
 
 	inline TaskloopMetadata(
@@ -51,7 +121,14 @@ public:
 		TaskMetadata(argsBlock, argsBlockSize, taskPointer, flags, taskAccessInfo, taskMetadataSize, locallyAllocated),
 		_bounds(),
 		_source(false),
-		_maxChildDeps(0)
+		_maxChildDeps(0),
+		_parallelGeneration(false),
+		_childRegistrationLock(),
+		_pendingGenerators(0),
+		_schedule(STATIC_SCHEDULE),
+		_selfScheduled(false),
+		_numWorkers(0),
+		_cursor(0)
 	{
 	}
 
@@ -69,6 +146,19 @@ public:
 		if (_bounds.grainsize == 0) {
 			_bounds.grainsize = std::max(totalIterations / nosv_get_num_cpus(), (size_t) 1);
 		}
+
+		// Self-scheduled executors do not register accesses, so the taskloop must not have
+		// reductions, which need the private storage of each executor. Taskiter children
+		// replay a fixed graph, and if0 executors would run one after the other anyway.
+		// Taskloops with weak accesses fall back to the static schedule when registering them
+		if (_configuredSchedule != STATIC_SCHEDULE && !isIf0() && !isTaskiterChild()) {
+			nanos6_task_info_t *taskInfo = TaskMetadata::getTaskInfo(_task);
+			assert(taskInfo != nullptr);
+
+			if (taskInfo->reduction_initializers == nullptr) {
+				_schedule = _configuredSchedule;
+			}
+		}
 	}
 
 	inline bounds_t &getBounds()
@@ -83,9 +173,58 @@ public:
 
 	inline size_t getMaxChildDependencies() const
 	{
-		return _maxChildDeps;
+		return (_schedule == STATIC_SCHEDULE) ? _maxChildDeps : 0;
+	}
+
+	//! \brief Whether new sources register their accesses dynamically instead of reserving
+	//! room for the accesses of every chunk
+	//!
+	//! \param[in] taskiterChild Whether the source is created inside a taskiter
+	static inline bool coalescesDependencies(bool taskiterChild)
+	{
+		return (_coalesceDependencies.getValue() && !taskiterChild);
 	}
 
+	inline bool isSelfSchedulingSource() const override
+	{
+		return (_source && _schedule != STATIC_SCHEDULE);
+	}
+
+	//! \brief Make a source use the static schedule, which must happen before it creates
+	//! any executor
+	inline void disableSelfScheduling()
+	{
+		assert(_source);
+		_schedule = STATIC_SCHEDULE;
+	}
+
+	inline void setSelfScheduled()
+	{
+		assert(!_source);
+		_selfScheduled = true;
+	}
+
+	//! \brief Get the taskloop that hands out the chunks to be run by this task
+	//!
+	//! \returns The source for self-scheduled executors, itself for self-scheduling sources,
+	//! or nullptr if this task runs only the chunk in its bounds
+	inline TaskloopMetadata *getChunkScheduler()
+	{
+		if (_selfScheduled) {
+			return (TaskloopMetadata *) getParent();
+		} else if (isSelfSchedulingSource()) {
+			return this;
+		}
+		return nullptr;
+	}
+
+	//! \brief Take the next range of iterations of a self-scheduling source
+	//!
+	//! \param[out] chunkBounds The bounds of the range that was taken
+	//!
+	//! \returns Whether there were iterations left
+	bool acquireChunk(bounds_t &chunkBounds);
+
 	inline void increaseMaxChildDependencies() override
 	{
 		if (_source) {
@@ -98,6 +237,11 @@ public:
 		return _source;
 	}
 
+	inline SpinLock *getChildRegistrationLock() override
+	{
+		return (_parallelGeneration) ? &_childRegistrationLock : nullptr;
+	}
+
 	inline size_t getIterationCount() const
 	{
 		return (_bounds.upper_bound - _bounds.lower_bound);
@@ -107,6 +251,21 @@ public:
 
 	void generateChildTasks();
 
+	static inline bool isAdaptiveGrainsizeEnabled()
+	{
+		return (_targetChunkDuration.getValue() > 0);
+	}
+
+	//! \brief Choose the grainsize of a taskloop that did not specify one
+	//!
+	//! By default, the iterations are split evenly among the CPUs. With the adaptive grainsize,
+	//! the measured cost per iteration of previous instances of the same taskloop is used to
+	//! make chunks last the target duration, while keeping a few chunks per CPU
+	//!
+	//! \param[in] taskInfo The taskinfo of the taskloop
+	//! \param[in] iterations The number of iterations of the taskloop
+	static size_t chooseGrainsize(nanos6_task_info_t *taskInfo, size_t iterations);
+
 };
 
 namespace Taskloop {
@@ -119,12 +278,22 @@ namespace Taskloop {
 		return MathSupport::ceil(iterations, grainsize);
 	}
 
+	//! \brief Create and submit the executor of a chunk of a taskloop
+	//!
+	//! The executor is always linked to the source, even if it is created from a generator task
+	//!
+	//! \param[in] parentMetadata The source taskloop
+	//! \param[in] lowerBound The first iteration of the chunk
+	//! \param[in] upperBound The iteration after the last one of the chunk
 	static inline void createTaskloopExecutor(
-		nosv_task_t parent,
 		TaskloopMetadata *parentMetadata,
-		TaskloopMetadata::bounds_t &parentBounds
+		size_t lowerBound,
+		size_t upperBound
 	) {
 		assert(parentMetadata != nullptr);
+		assert(lowerBound < upperBound || parentMetadata->isSelfSchedulingSource());
+
+		nosv_task_t parent = parentMetadata->getTaskHandle();
 
 		// Retreive the args block and taskinfo of the task
 		nanos6_task_info_t *parentTaskInfo = TaskMetadata::getTaskInfo(parent);
@@ -170,17 +339,19 @@ namespace Taskloop {
 			}
 		}
 
-		// Set bounds of grainsize
-		size_t lowerBound = parentBounds.lower_bound;
-		size_t upperBound = std::min(lowerBound + parentBounds.grainsize, parentBounds.upper_bound);
-		parentBounds.lower_bound = upperBound;
-
 		TaskloopMetadata::bounds_t &childBounds = taskloopMetadata->getBounds();
 		childBounds.lower_bound = lowerBound;
 		childBounds.upper_bound = upperBound;
 
+		// Executors of self-scheduling sources take their chunks at run time
+		if (parentMetadata->isSelfSchedulingSource()) {
+			taskloopMetadata->setSelfScheduled();
+		}
+
 		// Submit task and register dependencies
-		nanos6_submit_task(taskPointer);
+		taskloopMetadata->computePriority();
+		taskloopMetadata->setParent(parent);
+		TaskCreation::submitTask((nosv_task_t) taskPointer);
 	}
 
 };
@@ -0,0 +1,266 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test the release of the accesses of a task through their symbols. The tasks are
+ * created through the instantiation API, so the symbol of each access is explicit
+ */
+
+#include <nodes.h>
+
+#include "Atomic.hpp"
+#include "TAPDriver.hpp"
+#include "Timer.hpp"
+
+
+#define TIMEOUT_MICROSECONDS 2000000L
+#define SUSTAIN_MICROSECONDS 100000L
+#define ITERATIONS 4
+
+TAPDriver tap;
+
+typedef void (*run_function_t)(void *, void *, nanos6_address_translation_entry_t *);
+typedef void (*register_function_t)(void *, void *, void *);
+
+struct TaskType {
+	nanos6_task_implementation_info_t _implementation;
+	nanos6_task_info_t _info;
+
+	TaskType(char const *label, run_function_t run, register_function_t registerDependencies)
+		: _implementation(), _info()
+	{
+		_implementation.device_type_id = nanos6_host_device;
+		_implementation.run = run;
+		_implementation.task_type_label = label;
+		_implementation.declaration_source = "discrete-deps-release-symbol";
+
+		_info.register_depinfo = registerDependencies;
+		_info.implementation_count = 1;
+		_info.implementations = &_implementation;
+		_info.coro_handle_idx = -1;
+
+		nanos6_register_task_info(&_info);
+	}
+};
+
+static nanos6_task_invocation_info_t invocationInfo = { "discrete-deps-release-symbol" };
+
+static void submit(TaskType &type, size_t numDeps)
+{
+	void *args;
+	void *task;
+	nanos6_create_task(&type._info, &invocationInfo, type._implementation.task_type_label,
+		sizeof(void *), &args, &task, 0, numDeps);
+	nanos6_submit_task(task);
+}
+
+//! \brief Wait until a counter reaches a value, letting other tasks run meanwhile
+//!
+//! \returns Whether the counter reached the value before the timeout
+static bool waitFor(Atomic<int> &counter, int value, long microseconds)
+{
+	Timer timer;
+	while (counter.load() < value) {
+		if (timer.lap() > (double) microseconds)
+			return false;
+		nanos6_yield();
+	}
+	return true;
+}
+
+static void registerRead(void *handler, int symbol, int *address)
+{
+	nanos6_register_region_read_depinfo1(handler, symbol, "in", address, sizeof(int), 0, sizeof(int));
+}
+
+static void registerReadWrite(void *handler, int symbol, int *address)
+{
+	nanos6_register_region_readwrite_depinfo1(handler, symbol, "inout", address, sizeof(int), 0, sizeof(int));
+}
+
+// A task with two symbols releases the first one, and only the successors
+// of the first one start before it finishes
+
+int a, b;
+Atomic<int> firstConsumerFinished(0);
+Atomic<int> producerFinished(0);
+bool firstConsumerRanEarly;
+bool secondConsumerRanLate;
+
+static void producerRegister(void *, void *, void *handler)
+{
+	registerReadWrite(handler, 0, &a);
+	registerReadWrite(handler, 1, &b);
+}
+
+static void producerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	a = 1;
+	nanos6_release_symbol(0);
+
+	firstConsumerRanEarly = waitFor(firstConsumerFinished, 1, TIMEOUT_MICROSECONDS);
+
+	b = 1;
+	producerFinished = 1;
+}
+
+static void firstConsumerRegister(void *, void *, void *handler)
+{
+	registerRead(handler, 0, &a);
+}
+
+static void firstConsumerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	firstConsumerFinished = (a == 1) ? 1 : 0;
+}
+
+static void secondConsumerRegister(void *, void *, void *handler)
+{
+	registerRead(handler, 0, &b);
+}
+
+static void secondConsumerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	secondConsumerRanLate = (producerFinished.load() == 1 && b == 1);
+}
+
+// An access reached through two symbols is only released once both are released
+
+int c;
+Atomic<int> sharedConsumerStarted(0);
+bool sharedConsumerWaitedFirst;
+bool sharedConsumerRanAfterSecond;
+
+static void sharedProducerRegister(void *, void *, void *handler)
+{
+	registerReadWrite(handler, 0, &c);
+	registerReadWrite(handler, 1, &c);
+}
+
+static void sharedProducerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	c = 1;
+
+	nanos6_release_symbol(0);
+	sharedConsumerWaitedFirst = !waitFor(sharedConsumerStarted, 1, SUSTAIN_MICROSECONDS);
+
+	nanos6_release_symbol(1);
+	sharedConsumerRanAfterSecond = waitFor(sharedConsumerStarted, 1, TIMEOUT_MICROSECONDS);
+}
+
+static void sharedConsumerRegister(void *, void *, void *handler)
+{
+	registerRead(handler, 0, &c);
+}
+
+static void sharedConsumerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	sharedConsumerStarted = (c == 1) ? 1 : 0;
+}
+
+// A taskiter child releases early while the graph is built in the first iteration,
+// and at its completion in the following ones
+
+int d, e;
+Atomic<int> iterProducerRuns(0);
+Atomic<int> iterConsumerRuns(0);
+bool iterReleasedEarly;
+bool iterReleasedLate = true;
+bool iterOrdered = true;
+
+static void iterProducerRegister(void *, void *, void *handler)
+{
+	registerReadWrite(handler, 0, &d);
+	registerReadWrite(handler, 1, &e);
+}
+
+static void iterProducerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	const int iteration = iterProducerRuns.load();
+
+	d = iteration;
+	nanos6_release_symbol(0);
+
+	if (iteration == 0) {
+		iterReleasedEarly = waitFor(iterConsumerRuns, 1, TIMEOUT_MICROSECONDS);
+	} else if (waitFor(iterConsumerRuns, iteration + 1, SUSTAIN_MICROSECONDS)) {
+		iterReleasedLate = false;
+	}
+
+	e = iteration;
+	iterProducerRuns = iteration + 1;
+}
+
+static void iterConsumerRegister(void *, void *, void *handler)
+{
+	registerRead(handler, 0, &d);
+}
+
+static void iterConsumerRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	if (d != iterConsumerRuns.load())
+		iterOrdered = false;
+
+	iterConsumerRuns++;
+}
+
+TaskType *iterProducer;
+TaskType *iterConsumer;
+
+static void taskiterRun(void *, void *, nanos6_address_translation_entry_t *)
+{
+	submit(*iterProducer, 2);
+	submit(*iterConsumer, 1);
+}
+
+int main()
+{
+	TaskType producer("producer", producerRun, producerRegister);
+	TaskType firstConsumer("first consumer", firstConsumerRun, firstConsumerRegister);
+	TaskType secondConsumer("second consumer", secondConsumerRun, secondConsumerRegister);
+
+	submit(producer, 2);
+	submit(firstConsumer, 1);
+	submit(secondConsumer, 1);
+	nanos6_taskwait("discrete-deps-release-symbol");
+
+	tap.evaluate(firstConsumerRanEarly, "The successor of a released symbol runs while its predecessor is running");
+	tap.evaluate(secondConsumerRanLate, "The successor of an unreleased symbol waits for its predecessor to finish");
+
+	TaskType sharedProducer("shared producer", sharedProducerRun, sharedProducerRegister);
+	TaskType sharedConsumer("shared consumer", sharedConsumerRun, sharedConsumerRegister);
+
+	submit(sharedProducer, 2);
+	submit(sharedConsumer, 1);
+	nanos6_taskwait("discrete-deps-release-symbol");
+
+	tap.evaluate(sharedConsumerWaitedFirst, "An access reached through two symbols is kept when only one is released");
+	tap.evaluate(sharedConsumerRanAfterSecond, "An access reached through two symbols is released with the last one");
+
+	TaskType taskiter("taskiter", taskiterRun, nullptr);
+	iterProducer = new TaskType("taskiter producer", iterProducerRun, iterProducerRegister);
+	iterConsumer = new TaskType("taskiter consumer", iterConsumerRun, iterConsumerRegister);
+
+	void *args;
+	void *task;
+	nanos6_create_iter(&taskiter._info, &invocationInfo, "taskiter", sizeof(void *), &args, &task,
+		nanos6_taskiter_task, 0, 0, ITERATIONS, 1);
+	nanos6_submit_task(task);
+	nanos6_taskwait("discrete-deps-release-symbol");
+
+	tap.evaluate(iterProducerRuns.load() == ITERATIONS && iterConsumerRuns.load() == ITERATIONS,
+		"Every iteration of the taskiter runs its children");
+	tap.evaluate(iterOrdered, "The taskiter children see the data of their iteration");
+	tap.evaluate(iterReleasedEarly, "A taskiter child releases its symbol early in the first iteration");
+	tap.evaluate(iterReleasedLate, "A taskiter child releases its symbol at completion in the following iterations");
+
+	delete iterProducer;
+	delete iterConsumer;
+
+	tap.end();
+
+	return 0;
+}
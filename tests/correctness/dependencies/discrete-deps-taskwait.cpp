@@ -0,0 +1,94 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <cassert>
+#include <unistd.h>
+
+#include <nodes.h>
+
+#include "Atomic.hpp"
+#include "TAPDriver.hpp"
+
+
+#define SLEEP_MICROSECONDS 50000
+
+TAPDriver tap;
+
+int main()
+{
+	long activeCPUs = nanos6_get_total_num_cpus();
+	if (activeCPUs < 2) {
+		tap.skip("This test does not work with less than 2 CPUs");
+		tap.end();
+		return 0;
+	}
+
+	int a = 0, b = 0, c = 0;
+	Atomic<bool> writerFinished(false);
+	Atomic<bool> blockerReleased(false);
+	Atomic<bool> blockerFinished(false);
+	Atomic<bool> readerReleased(false);
+	Atomic<bool> readerFinished(false);
+
+	#pragma oss task out(a) shared(writerFinished) label("writer")
+	{
+		usleep(SLEEP_MICROSECONDS);
+		a = 1;
+		writerFinished = true;
+	}
+
+	// This task only finishes after the taskwait on "a" returns, so a full taskwait would hang
+	#pragma oss task inout(b) shared(blockerReleased, blockerFinished) label("blocker")
+	{
+		while (!blockerReleased.load());
+		b = 1;
+		blockerFinished = true;
+	}
+
+	nanos6_taskwait_in(&a, sizeof(a), "discrete-deps-taskwait");
+
+	tap.evaluate(writerFinished.load() && a == 1, "The taskwait on a region waits for its writer");
+	tap.evaluate(!blockerFinished.load(), "The taskwait on a region does not wait for unrelated children");
+
+	#pragma oss task in(c) shared(readerReleased, readerFinished) label("reader")
+	{
+		while (!readerReleased.load());
+		readerFinished = true;
+	}
+
+	nanos6_taskwait_in(&c, sizeof(c), "discrete-deps-taskwait");
+
+	tap.evaluate(!readerFinished.load(), "An input taskwait does not wait for the readers of the region");
+
+	readerReleased = true;
+	nanos6_taskwait_out(&c, sizeof(c), "discrete-deps-taskwait");
+
+	tap.evaluate(readerFinished.load(), "An output taskwait waits for the readers of the region");
+
+	blockerReleased = true;
+
+	int array[4] = { 0, 0, 0, 0 };
+	Atomic<bool> partialWriterFinished(false);
+
+	#pragma oss task out(array[1]) shared(partialWriterFinished) label("partial writer")
+	{
+		usleep(SLEEP_MICROSECONDS);
+		array[1] = 1;
+		partialWriterFinished = true;
+	}
+
+	nanos6_taskwait_in(array, sizeof(array), "discrete-deps-taskwait");
+
+	tap.evaluate(partialWriterFinished.load() && array[1] == 1, "The taskwait on a region waits for the writers of a part of it");
+
+	#pragma oss taskwait
+
+	tap.evaluate(blockerFinished.load() && b == 1, "The remaining children finish before the final taskwait");
+
+	tap.end();
+
+	return 0;
+}
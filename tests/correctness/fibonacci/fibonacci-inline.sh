@@ -0,0 +1,11 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run fibonacci inlining any ready task as soon as a CPU has one queued
+export NODES_INLINE_TASKS=1
+export NODES_INLINE_QUEUE_THRESHOLD=1
+export NODES_INLINE_COST_THRESHOLD=0
+exec ./fibonacci.test "$@"
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run final-cutoff turning the tasks final from the fourth nesting level
+export NODES_FINAL_DEPTH_CUTOFF=4
+exec ./final-cutoff.test "$@"
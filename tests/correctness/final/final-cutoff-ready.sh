@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run final-cutoff turning the tasks final when their CPU has two queued tasks
+export NODES_FINAL_READY_CUTOFF=2
+exec ./final-cutoff.test "$@"
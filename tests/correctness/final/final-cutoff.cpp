@@ -0,0 +1,100 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test the final cutoffs of recursive task trees. When NODES_FINAL_DEPTH_CUTOFF is
+ * set, the tasks at that nesting level or deeper must be final and the ones above
+ * must not. With any cutoff, the result must not change
+ */
+
+#include <cstdlib>
+#include <sstream>
+
+#include "Atomic.hpp"
+#include "TAPDriver.hpp"
+
+
+#define N 18
+
+TAPDriver tap;
+
+size_t depthCutoff = 0;
+
+Atomic<long> finalBelowCutoff(0);
+Atomic<long> notFinalAboveCutoff(0);
+Atomic<long> finalCalls(0);
+
+void fibonacci(long index, size_t depth, long *resultPointer)
+{
+	if (depthCutoff > 0) {
+		bool final = nanos6_in_final();
+		if (final)
+			finalCalls++;
+
+		if (depth >= depthCutoff && !final) {
+			notFinalAboveCutoff++;
+		} else if (depth < depthCutoff && final) {
+			finalBelowCutoff++;
+		}
+	}
+
+	if (index <= 1) {
+		*resultPointer = index;
+		return;
+	}
+
+	long result1, result2;
+
+	#pragma oss task shared(result1) label("fibonacci")
+	fibonacci(index - 1, depth + 1, &result1);
+
+	#pragma oss task shared(result2) label("fibonacci")
+	fibonacci(index - 2, depth + 1, &result2);
+
+	#pragma oss taskwait
+	*resultPointer = result1 + result2;
+}
+
+long serialFibonacci(long index)
+{
+	long previous = 0, current = 1;
+	for (long i = 0; i < index; ++i) {
+		long next = previous + current;
+		previous = current;
+		current = next;
+	}
+	return previous;
+}
+
+int main()
+{
+	const char *cutoff = std::getenv("NODES_FINAL_DEPTH_CUTOFF");
+	if (cutoff != nullptr)
+		depthCutoff = std::strtoul(cutoff, nullptr, 10);
+
+	long result;
+
+	// The main task is at the nesting level 0
+	#pragma oss task shared(result) label("fibonacci")
+	fibonacci(N, 1, &result);
+
+	#pragma oss taskwait
+
+	std::ostringstream oss;
+	oss << "Expected result: " << result << " == " << serialFibonacci(N);
+	tap.evaluate(result == serialFibonacci(N), oss.str());
+
+	if (depthCutoff > 0) {
+		tap.emitDiagnostic("Calls in final context: ", finalCalls.load());
+		tap.evaluate(finalCalls.load() > 0, "The depth cutoff turned some tasks final");
+		tap.evaluate(notFinalAboveCutoff.load() == 0, "Every task at the depth cutoff or deeper is final");
+		tap.evaluate(finalBelowCutoff.load() == 0, "No task above the depth cutoff is final");
+	}
+
+	tap.end();
+
+	return 0;
+}
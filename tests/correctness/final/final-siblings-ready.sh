@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run final-siblings turning the tasks final as soon as their CPU has a queued task
+export NODES_FINAL_READY_CUTOFF=1
+exec ./final-siblings.test "$@"
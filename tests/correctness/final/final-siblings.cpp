@@ -0,0 +1,76 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test that the final cutoffs do not break the dependencies between siblings. Each
+ * parent creates delayed writers and then the readers of their data. When a cutoff
+ * is reached in between, the readers must still wait for the writers
+ */
+
+#include <nodes.h>
+
+#include "Atomic.hpp"
+#include "TAPDriver.hpp"
+
+
+#define PARENTS 16
+#define WRITERS 8
+#define WRITER_DELAY_US 1000
+
+TAPDriver tap;
+
+int data[PARENTS][WRITERS];
+Atomic<int> errors(0);
+Atomic<int> finalParents(0);
+
+static void parent(int p, int round)
+{
+	int *values = data[p];
+
+	for (int w = 0; w < WRITERS; ++w) {
+		#pragma oss task out(values[w]) firstprivate(round)
+		{
+			nanos6_wait_for(WRITER_DELAY_US);
+			values[w] = round;
+		}
+	}
+
+	for (int w = 0; w < WRITERS; ++w) {
+		#pragma oss task inout(values[w]) firstprivate(round)
+		{
+			if (values[w] != round)
+				errors++;
+			values[w] = -round;
+		}
+	}
+
+	if (nanos6_in_final())
+		finalParents++;
+
+	#pragma oss taskwait
+
+	for (int w = 0; w < WRITERS; ++w) {
+		if (values[w] != -round)
+			errors++;
+	}
+}
+
+int main()
+{
+	for (int round = 1; round <= 4; ++round) {
+		for (int p = 0; p < PARENTS; ++p) {
+			#pragma oss task firstprivate(p, round)
+			parent(p, round);
+		}
+		#pragma oss taskwait
+	}
+
+	tap.emitDiagnostic("Parents that ended up final: ", finalParents.load());
+	tap.evaluate(errors.load() == 0, "The readers created after the writers read their values");
+	tap.end();
+
+	return 0;
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run red-large privatizing the reduction lazily
+export NODES_REDUCTION_LAZY_PRIVATIZATION=1
+exec ./red-large.test "$@"
@@ -0,0 +1,53 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test reductions over arrays that are large enough to be combined in parallel
+ * chunks, checking every element so that misplaced or missing chunks are noticed
+ */
+
+#include "TAPDriver.hpp"
+
+
+// 8 MiB, above the default threshold of the parallel combination
+#define N (1 << 20)
+#define TASKS 128
+#define ROUNDS 3
+
+TAPDriver tap;
+
+double values[N];
+
+int main()
+{
+	for (int i = 0; i < N; ++i)
+		values[i] = (double) i;
+
+	for (int round = 0; round < ROUNDS; ++round) {
+		for (int t = 0; t < TASKS; ++t) {
+			#pragma oss task reduction(+: values)
+			{
+				for (int i = 0; i < N; ++i)
+					values[i] += (double) (i % 7 + t);
+			}
+		}
+
+		#pragma oss taskwait
+
+		// Every round adds the same amount, so the expected value is a multiple of it
+		bool correct = true;
+		for (int i = 0; i < N && correct; ++i) {
+			double expected = (double) i + (double) (round + 1) * ((double) TASKS * (i % 7) + (TASKS * (TASKS - 1)) / 2);
+			if (values[i] != expected) {
+				tap.emitDiagnostic("Incorrect value at ", i, ": ", values[i], " instead of ", expected);
+				correct = false;
+			}
+		}
+		tap.evaluate(correct, "Large array reduction has the expected results in every element");
+	}
+
+	tap.end();
+}
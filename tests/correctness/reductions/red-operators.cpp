@@ -0,0 +1,96 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test the reductions over the operators and types that have built-in kernels,
+ * on both scalars and arrays
+ */
+
+#include <sstream>
+
+#include "TAPDriver.hpp"
+
+
+#define N 4096
+#define TASKS 64
+
+TAPDriver tap;
+
+int sum[N];
+double product[N];
+long minimum[N];
+float maximum[N];
+unsigned int bitAnd[N];
+unsigned char bitOr[N];
+
+int main()
+{
+	for (int i = 0; i < N; ++i) {
+		sum[i] = i;
+		product[i] = 1.0;
+		minimum[i] = i;
+		maximum[i] = -1.0f;
+		bitAnd[i] = ~0U;
+		bitOr[i] = 0;
+	}
+
+	bool logicalAnd = true;
+	bool logicalOr = false;
+	long long scalarSum = 0;
+
+	for (int t = 0; t < TASKS; ++t) {
+		#pragma oss task reduction(+: sum, scalarSum) reduction(*: product) \
+			reduction(min: minimum) reduction(max: maximum) \
+			reduction(&: bitAnd) reduction(|: bitOr) \
+			reduction(&&: logicalAnd) reduction(||: logicalOr)
+		{
+			for (int i = 0; i < N; ++i) {
+				sum[i] += 1;
+				product[i] *= 2.0;
+				minimum[i] = (i - t < minimum[i]) ? i - t : minimum[i];
+				maximum[i] = ((float) t > maximum[i]) ? (float) t : maximum[i];
+				bitAnd[i] &= ~(1U << (t % 32));
+				bitOr[i] |= (unsigned char) (1U << (t % 8));
+			}
+			scalarSum += t;
+			logicalAnd = logicalAnd && (t < TASKS);
+			logicalOr = logicalOr || (t == TASKS - 1);
+		}
+	}
+
+	#pragma oss taskwait
+
+	bool correct = true;
+	for (int i = 0; i < N && correct; ++i) {
+		if (sum[i] != i + TASKS) {
+			tap.emitDiagnostic("Incorrect sum at ", i, ": ", sum[i]);
+			correct = false;
+		} else if (product[i] != (double) (1ULL << TASKS / 2) * (double) (1ULL << TASKS / 2)) {
+			tap.emitDiagnostic("Incorrect product at ", i, ": ", product[i]);
+			correct = false;
+		} else if (minimum[i] != i - (TASKS - 1)) {
+			tap.emitDiagnostic("Incorrect minimum at ", i, ": ", minimum[i]);
+			correct = false;
+		} else if (maximum[i] != (float) (TASKS - 1)) {
+			tap.emitDiagnostic("Incorrect maximum at ", i, ": ", maximum[i]);
+			correct = false;
+		} else if (bitAnd[i] != 0U) {
+			tap.emitDiagnostic("Incorrect bitwise and at ", i, ": ", bitAnd[i]);
+			correct = false;
+		} else if (bitOr[i] != 0xFF) {
+			tap.emitDiagnostic("Incorrect bitwise or at ", i, ": ", (int) bitOr[i]);
+			correct = false;
+		}
+	}
+	tap.evaluate(correct, "Array reductions have the expected results");
+
+	std::ostringstream oss;
+	oss << "Expected scalar reduction result: " << scalarSum << " == " << (TASKS * (TASKS - 1)) / 2;
+	tap.evaluate(scalarSum == (TASKS * (TASKS - 1)) / 2, oss.str());
+	tap.evaluate(logicalAnd && logicalOr, "Logical reductions have the expected results");
+
+	tap.end();
+}
@@ -0,0 +1,93 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test a large histogram reduction where each task only updates a few sparse bins
+ * and a contiguous run of bins that spans several pages, so that the private copies
+ * are mostly untouched when the reduction is privatized lazily
+ */
+
+#include <vector>
+
+#include "TAPDriver.hpp"
+
+
+// 2 MiB, above the default threshold of the lazy privatization
+#define BINS (1 << 19)
+#define TASKS 64
+#define SAMPLES 512
+#define RUN_LENGTH 5000
+
+TAPDriver tap;
+
+int histogram[BINS];
+volatile int sink;
+
+static inline unsigned int nextRandom(unsigned int &state)
+{
+	state = state * 1103515245U + 12345U;
+	return state >> 8;
+}
+
+static inline size_t getRunStart(int t)
+{
+	// Not aligned to pages, so the run starts and ends in the middle of a page
+	return ((size_t) t * 7919 * 13 + 1000) % (BINS - RUN_LENGTH);
+}
+
+int main()
+{
+	std::vector<int> expected(BINS);
+	for (int i = 0; i < BINS; ++i) {
+		histogram[i] = i % 3;
+		expected[i] = i % 3;
+	}
+
+	for (int t = 0; t < TASKS; ++t) {
+		unsigned int state = t;
+		for (int s = 0; s < SAMPLES; ++s)
+			expected[nextRandom(state) % BINS]++;
+
+		for (size_t i = getRunStart(t); i < getRunStart(t) + RUN_LENGTH; ++i)
+			expected[i] += 2;
+	}
+
+	for (int t = 0; t < TASKS; ++t) {
+		#pragma oss task reduction(+: histogram)
+		{
+			unsigned int state = t;
+			for (int s = 0; s < SAMPLES; ++s)
+				histogram[nextRandom(state) % BINS]++;
+
+			for (size_t i = getRunStart(t); i < getRunStart(t) + RUN_LENGTH; ++i)
+				histogram[i] += 2;
+		}
+	}
+
+	// Tasks that only read the private copy, which must not change the result
+	for (int t = 0; t < TASKS / 8; ++t) {
+		#pragma oss task reduction(+: histogram)
+		{
+			int local = 0;
+			for (int i = 0; i < BINS; i += 1024)
+				local += histogram[i];
+			sink = local;
+		}
+	}
+
+	#pragma oss taskwait
+
+	bool correct = true;
+	for (int i = 0; i < BINS && correct; ++i) {
+		if (histogram[i] != expected[i]) {
+			tap.emitDiagnostic("Incorrect bin ", i, ": ", histogram[i], " instead of ", expected[i]);
+			correct = false;
+		}
+	}
+	tap.evaluate(correct, "Sparse histogram reduction has the expected results in every bin");
+
+	tap.end();
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run taskloop-deps-order coalescing the accesses of the taskloop sources
+export NODES_TASKLOOP_COALESCE_DEPS=1
+exec ./taskloop-deps-order.test "$@"
@@ -0,0 +1,74 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test that the chunks of a taskloop wait for the tasks that write their data before
+ * it. The writers are delayed, so a chunk that does not wait for its writer reads the
+ * old values. The taskloop has accesses that depend on the loop variable and one that
+ * does not, which are handled differently when the accesses of the taskloop are coalesced
+ */
+
+#include <nodes.h>
+
+#include "TAPDriver.hpp"
+
+
+#define N (64 * 1024)
+#define BLOCKSIZE 1024
+#define ROUNDS 4
+#define WRITER_DELAY_US 2000
+
+TAPDriver tap;
+
+int input[N];
+int output[N];
+int offset;
+
+int main()
+{
+	for (int i = 0; i < N; ++i) {
+		input[i] = 0;
+		output[i] = -1;
+	}
+	offset = 0;
+
+	bool correct = true;
+	for (int round = 1; round <= ROUNDS && correct; ++round) {
+		for (int i = 0; i < N; i += BLOCKSIZE) {
+			#pragma oss task out(input[i]) firstprivate(round)
+			{
+				nanos6_wait_for(WRITER_DELAY_US);
+				for (int j = i; j < i + BLOCKSIZE; ++j)
+					input[j] = round;
+			}
+		}
+
+		#pragma oss task out(offset) firstprivate(round)
+		{
+			nanos6_wait_for(WRITER_DELAY_US);
+			offset = round * N;
+		}
+
+		#pragma oss taskloop in(input[i], offset) out(output[i]) grainsize(BLOCKSIZE)
+		for (int i = 0; i < N; ++i) {
+			output[i] = input[i] + offset;
+		}
+
+		#pragma oss taskwait
+
+		for (int i = 0; i < N && correct; ++i) {
+			if (output[i] != round + round * N) {
+				tap.emitDiagnostic("Round ", round, ": incorrect element ", i, ": ", output[i], " instead of ", round + round * N);
+				correct = false;
+			}
+		}
+	}
+
+	tap.evaluate(correct, "Every chunk of the taskloop ran after the writers of its data");
+	tap.end();
+
+	return 0;
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+
+#	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+#
+#	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+
+# Run taskloop-schedule with the guided schedule
+export NODES_TASKLOOP_SCHEDULE=guided
+exec ./taskloop-schedule.test "$@"
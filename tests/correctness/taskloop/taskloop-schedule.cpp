@@ -0,0 +1,104 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+/*
+ * Test the taskloop schedules selected with NODES_TASKLOOP_SCHEDULE. Every iteration
+ * must run exactly once, after the writers of the data of the taskloop and before its
+ * successors. Taskloops with weak accesses must link the tasks nested in their chunks
+ */
+
+#include <nodes.h>
+
+#include "Atomic.hpp"
+#include "TAPDriver.hpp"
+
+
+#define N (64 * 1024)
+#define NESTED 256
+#define ROUNDS 4
+#define WRITER_DELAY_US 2000
+
+TAPDriver tap;
+
+int data[N];
+int hits[N];
+long value;
+Atomic<int> errors(0);
+
+int main()
+{
+	for (int i = 0; i < N; ++i) {
+		data[i] = 0;
+		hits[i] = 0;
+	}
+	value = 0;
+
+	for (int round = 1; round <= ROUNDS; ++round) {
+		#pragma oss task out(data[0;N]) firstprivate(round)
+		{
+			nanos6_wait_for(WRITER_DELAY_US);
+			for (int i = 0; i < N; ++i)
+				data[i] = round;
+		}
+
+		#pragma oss taskloop inout(data[0;N])
+		for (int i = 0; i < N; ++i) {
+			data[i]++;
+			hits[i]++;
+		}
+
+		// Not preceded by a taskwait, so it relies on the release of the taskloop accesses
+		// waiting for every chunk
+		#pragma oss task in(data[0;N]) firstprivate(round)
+		{
+			for (int i = 0; i < N; ++i) {
+				if (data[i] != round + 1) {
+					errors++;
+					break;
+				}
+			}
+		}
+	}
+
+	#pragma oss taskwait
+
+	bool once = true;
+	for (int i = 0; i < N && once; ++i) {
+		if (hits[i] != ROUNDS) {
+			tap.emitDiagnostic("Iteration ", i, " ran ", hits[i], " times instead of ", ROUNDS);
+			once = false;
+		}
+	}
+	tap.evaluate(once, "Every iteration of the taskloops ran exactly once");
+	tap.evaluate(errors.load() == 0, "The taskloops ran after their predecessors and before their successors");
+
+	for (int round = 1; round <= ROUNDS; ++round) {
+		#pragma oss task out(value) firstprivate(round)
+		{
+			nanos6_wait_for(WRITER_DELAY_US);
+			value = round * NESTED;
+		}
+
+		#pragma oss taskloop weakinout(value)
+		for (int i = 0; i < NESTED; ++i) {
+			#pragma oss task inout(value)
+			value++;
+		}
+
+		#pragma oss task in(value) firstprivate(round)
+		{
+			if (value != (round + 1) * NESTED)
+				errors++;
+		}
+	}
+
+	#pragma oss taskwait
+
+	tap.evaluate(errors.load() == 0, "The tasks nested in taskloops with weak accesses are linked to their accesses");
+	tap.end();
+
+	return 0;
+}
@@ -0,0 +1,229 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+// Implementation of the subset of the nOS-V API that the runtime uses, on top of the
+// simulator. The replay tool is linked with this file instead of the nOS-V library
+
+#include <cassert>
+
+#include <nosv.h>
+#include <nosv/affinity.h>
+#include <nosv/hwinfo.h>
+
+#include "Simulator.hpp"
+
+
+extern "C" {
+
+int nosv_init(void)
+{
+	return 0;
+}
+
+int nosv_shutdown(void)
+{
+	return 0;
+}
+
+const char *nosv_get_error_string(int)
+{
+	return "Unsupported operation in the simulated nOS-V";
+}
+
+int nosv_type_init(
+	nosv_task_type_t *type,
+	nosv_task_run_callback_t run_callback,
+	nosv_task_end_callback_t end_callback,
+	nosv_task_completed_callback_t completed_callback,
+	const char *label,
+	void *metadata,
+	nosv_cost_function_t cost_function,
+	nosv_flags_t
+) {
+	assert(type != nullptr);
+
+	*type = new nosv_task_type{
+		run_callback, end_callback, completed_callback,
+		(label != nullptr) ? label : "", metadata, cost_function
+	};
+	return 0;
+}
+
+int nosv_type_destroy(nosv_task_type_t type, nosv_flags_t)
+{
+	delete type;
+	return 0;
+}
+
+void *nosv_get_task_type_metadata(nosv_task_type_t type)
+{
+	return type->_metadata;
+}
+
+nosv_task_type_t nosv_get_task_type(nosv_task_t task)
+{
+	return task->_type;
+}
+
+int nosv_create(nosv_task_t *task, nosv_task_type_t type, size_t metadata_size, nosv_flags_t)
+{
+	assert(task != nullptr);
+
+	*task = Simulator::createTask(type, metadata_size);
+	return 0;
+}
+
+int nosv_destroy(nosv_task_t task, nosv_flags_t)
+{
+	Simulator::destroyTask(task);
+	return 0;
+}
+
+void *nosv_get_task_metadata(nosv_task_t task)
+{
+	return task->_metadata;
+}
+
+int nosv_get_task_priority(nosv_task_t task)
+{
+	return task->_priority;
+}
+
+void nosv_set_task_priority(nosv_task_t task, int priority)
+{
+	task->_priority = priority;
+}
+
+int nosv_set_task_affinity(nosv_task_t task, nosv_affinity_t *affinity)
+{
+	// Affinities are kept but not honored by the simulated scheduler
+	task->_affinity = *affinity;
+	return 0;
+}
+
+nosv_affinity_t nosv_affinity_get(uint32_t index, nosv_affinity_level_t level, nosv_affinity_type_t type)
+{
+	nosv_affinity_t affinity = {};
+	affinity.level = level;
+	affinity.type = type;
+	affinity.index = index;
+	return affinity;
+}
+
+nosv_affinity_t nosv_get_default_affinity(void)
+{
+	nosv_affinity_t affinity = {};
+	affinity.level = NOSV_AFFINITY_LEVEL_NONE;
+	return affinity;
+}
+
+int nosv_attach(nosv_task_t *task, nosv_affinity_t *, const char *, nosv_flags_t)
+{
+	Simulator::attach(task);
+	return 0;
+}
+
+int nosv_detach(nosv_flags_t)
+{
+	Simulator::detach();
+	return 0;
+}
+
+nosv_task_t nosv_self(void)
+{
+	return Simulator::self();
+}
+
+int nosv_submit(nosv_task_t task, nosv_flags_t flags)
+{
+	assert(task != nullptr);
+
+	Simulator::submit(task, flags);
+	return 0;
+}
+
+int nosv_pause(nosv_flags_t)
+{
+	Simulator::pause();
+	return 0;
+}
+
+int nosv_yield(nosv_flags_t)
+{
+	Simulator::yield();
+	return 0;
+}
+
+int nosv_waitfor(uint64_t target_ns, uint64_t *actual_ns)
+{
+	Simulator::waitFor(target_ns);
+	if (actual_ns != nullptr)
+		*actual_ns = target_ns;
+	return 0;
+}
+
+int nosv_suspend(void)
+{
+	Simulator::suspend();
+	return 0;
+}
+
+int nosv_set_suspend_mode(nosv_suspend_mode_t mode, uint64_t args)
+{
+	Simulator::setSuspendMode(mode, args);
+	return 0;
+}
+
+int nosv_increase_event_counter(uint64_t increment)
+{
+	Simulator::increaseEvents(increment);
+	return 0;
+}
+
+int nosv_decrease_event_counter(nosv_task_t task, uint64_t decrement)
+{
+	Simulator::decreaseEvents(task, decrement);
+	return 0;
+}
+
+// The simulated machine has a single NUMA node where logical and system CPUs match
+
+int nosv_get_num_cpus(void)
+{
+	return (int) Simulator::getNumWorkers();
+}
+
+int nosv_get_current_logical_cpu(void)
+{
+	return Simulator::getCurrentWorker();
+}
+
+int nosv_get_current_system_cpu(void)
+{
+	return Simulator::getCurrentWorker();
+}
+
+int nosv_get_num_numa_nodes(void)
+{
+	return 1;
+}
+
+int nosv_get_system_numa_id(int)
+{
+	return 0;
+}
+
+int nosv_get_logical_numa_id(int)
+{
+	return 0;
+}
+
+int nosv_get_num_cpus_in_numa(int)
+{
+	return (int) Simulator::getNumWorkers();
+}
+
+}
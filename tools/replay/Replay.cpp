@@ -0,0 +1,391 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+// Offline replay of a task graph recorded with NODES_GRAPH_RECORD. The recorded tasks are
+// created again with their types, accesses and flags through the runtime API, so the real
+// dependency system orders them, and each one spends its recorded execution time in a
+// simulated pool of workers
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <nodes/bootstrap.h>
+#include <nodes/library-mode.h>
+#include <nodes/multidimensional-dependencies.h>
+#include <nodes/task-info-registration.h>
+#include <nodes/task-instantiation.h>
+#include <nodes/taskwait.h>
+
+#include "Simulator.hpp"
+#include "common/ErrorHandler.hpp"
+#include "dependencies/DataAccessType.hpp"
+#include "instrument/GraphRecordFormat.hpp"
+
+
+struct replay_task_t;
+
+//! A child creation or a taskwait of a task, in the order they happened
+struct replay_step_t {
+	uint64_t _sequence;
+
+	//! Execution time of the task before the step
+	uint64_t _offset;
+
+	//! The created child, or nullptr for a taskwait
+	replay_task_t *_child;
+};
+
+struct replay_task_t {
+	//! Whether the task record was found, since the other records may refer to tasks
+	//! that were not recorded
+	bool _recorded;
+
+	uint64_t _id;
+	uint64_t _parentId;
+	uint64_t _offset;
+	uint32_t _typeId;
+	uint8_t _flags;
+
+	//! Sum of the recorded executions of the task
+	uint64_t _duration;
+
+	std::vector<GraphRecordFormat::access_record_t> _accesses;
+	std::vector<replay_step_t> _steps;
+};
+
+struct replay_type_t {
+	std::string _label;
+	nanos6_task_implementation_info_t _implementation;
+	nanos6_task_info_t _taskInfo;
+};
+
+struct replay_args_t {
+	replay_task_t *_task;
+};
+
+static std::unordered_map<uint64_t, replay_task_t> _tasks;
+static std::unordered_map<uint32_t, replay_type_t> _types;
+
+static nanos6_task_invocation_info_t _invocationInfo = { "replayed task" };
+
+template <typename T>
+static inline void readRecord(FILE *file, T &record, const char *path)
+{
+	if (fread(&record, sizeof(T), 1, file) != 1)
+		ErrorHandler::fail("Truncated task graph ", path);
+}
+
+static void loadGraph(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr)
+		ErrorHandler::fail("Could not open the task graph ", path);
+
+	char magic[sizeof(GraphRecordFormat::MAGIC)];
+	if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, GraphRecordFormat::MAGIC, sizeof(magic)) != 0)
+		ErrorHandler::fail(path, " is not a task graph recorded by NODES");
+
+	int kind;
+	while ((kind = fgetc(file)) != EOF) {
+		switch (kind) {
+			case GraphRecordFormat::TYPE_RECORD: {
+				GraphRecordFormat::type_record_t record;
+				readRecord(file, record, path);
+
+				std::string label(record._labelLength, '\0');
+				if (record._labelLength > 0 && fread(&label[0], record._labelLength, 1, file) != 1)
+					ErrorHandler::fail("Truncated task graph ", path);
+
+				_types[record._typeId]._label = label;
+				break;
+			}
+			case GraphRecordFormat::TASK_RECORD: {
+				GraphRecordFormat::task_record_t record;
+				readRecord(file, record, path);
+
+				replay_task_t &task = _tasks[record._taskId];
+				task._recorded = true;
+				task._id = record._taskId;
+				task._parentId = record._parentId;
+				task._offset = record._offset;
+				task._typeId = record._typeId;
+				task._flags = record._flags;
+				break;
+			}
+			case GraphRecordFormat::ACCESS_RECORD: {
+				GraphRecordFormat::access_record_t record;
+				readRecord(file, record, path);
+
+				_tasks[record._taskId]._accesses.push_back(record);
+				break;
+			}
+			case GraphRecordFormat::TASKWAIT_RECORD: {
+				GraphRecordFormat::taskwait_record_t record;
+				readRecord(file, record, path);
+
+				_tasks[record._taskId]._steps.push_back({ record._sequence, record._offset, nullptr });
+				break;
+			}
+			case GraphRecordFormat::EXECUTION_RECORD: {
+				GraphRecordFormat::execution_record_t record;
+				readRecord(file, record, path);
+
+				_tasks[record._taskId]._duration += record._duration;
+				break;
+			}
+			default:
+				ErrorHandler::fail("Unknown record ", kind, " in the task graph ", path);
+		}
+	}
+
+	fclose(file);
+}
+
+//! \brief Link the tasks to their parents
+//!
+//! \returns The tasks without parent, in creation order
+static std::vector<replay_task_t *> linkGraph()
+{
+	std::vector<replay_task_t *> roots;
+
+	for (auto &entry : _tasks) {
+		replay_task_t &task = entry.second;
+		if (!task._recorded)
+			continue;
+
+		auto parent = _tasks.find(task._parentId);
+		if (task._parentId != 0 && parent != _tasks.end() && parent->second._recorded) {
+			parent->second._steps.push_back({ task._id, task._offset, &task });
+		} else {
+			roots.push_back(&task);
+		}
+	}
+
+	for (auto &entry : _tasks) {
+		std::vector<replay_step_t> &steps = entry.second._steps;
+		std::sort(steps.begin(), steps.end(),
+			[](const replay_step_t &a, const replay_step_t &b) { return a._sequence < b._sequence; });
+	}
+
+	std::sort(roots.begin(), roots.end(),
+		[](const replay_task_t *a, const replay_task_t *b) { return a->_id < b->_id; });
+
+	return roots;
+}
+
+//! \brief Register the recorded accesses of a task. Reductions are registered as concurrent
+//! accesses, since their storage cannot be privatized without the original data
+static void registerAccesses(void *argsBlock, void *, void *handler)
+{
+	replay_task_t *task = ((replay_args_t *) argsBlock)->_task;
+
+	for (const GraphRecordFormat::access_record_t &access : task->_accesses) {
+		void *address = (void *) access._address;
+		const long length = (long) access._length;
+		const char *text = "replayed access";
+
+		switch ((DataAccessType) access._type) {
+			case READ_ACCESS_TYPE:
+				if (access._weak)
+					nanos6_register_region_weak_read_depinfo1(handler, 0, text, address, length, 0, length);
+				else
+					nanos6_register_region_read_depinfo1(handler, 0, text, address, length, 0, length);
+				break;
+			case WRITE_ACCESS_TYPE:
+				if (access._weak)
+					nanos6_register_region_weak_write_depinfo1(handler, 0, text, address, length, 0, length);
+				else
+					nanos6_register_region_write_depinfo1(handler, 0, text, address, length, 0, length);
+				break;
+			case READWRITE_ACCESS_TYPE:
+				if (access._weak)
+					nanos6_register_region_weak_readwrite_depinfo1(handler, 0, text, address, length, 0, length);
+				else
+					nanos6_register_region_readwrite_depinfo1(handler, 0, text, address, length, 0, length);
+				break;
+			case COMMUTATIVE_ACCESS_TYPE:
+				if (access._weak)
+					nanos6_register_region_weak_commutative_depinfo1(handler, 0, text, address, length, 0, length);
+				else
+					nanos6_register_region_commutative_depinfo1(handler, 0, text, address, length, 0, length);
+				break;
+			case CONCURRENT_ACCESS_TYPE:
+			case REDUCTION_ACCESS_TYPE:
+				if (access._weak)
+					nanos6_register_region_weak_readwrite_depinfo1(handler, 0, text, address, length, 0, length);
+				else
+					nanos6_register_region_concurrent_depinfo1(handler, 0, text, address, length, 0, length);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+static void replayTask(replay_task_t *task);
+
+static void runTask(void *argsBlock, void *, nanos6_address_translation_entry_t *)
+{
+	replayTask(((replay_args_t *) argsBlock)->_task);
+}
+
+static void runRoot(void *args)
+{
+	replayTask((replay_task_t *) args);
+}
+
+static replay_type_t &getType(uint32_t typeId)
+{
+	replay_type_t &type = _types[typeId];
+	if (type._taskInfo.implementations == nullptr) {
+		if (type._label.empty())
+			type._label = "Unknown type " + std::to_string(typeId);
+
+		type._implementation.device_type_id = nanos6_host_device;
+		type._implementation.run = &runTask;
+		type._implementation.task_type_label = type._label.c_str();
+		type._implementation.declaration_source = "replayed task type";
+
+		type._taskInfo.register_depinfo = &registerAccesses;
+		type._taskInfo.implementation_count = 1;
+		type._taskInfo.implementations = &type._implementation;
+		type._taskInfo.coro_handle_idx = -1;
+
+		nanos6_register_task_info(&type._taskInfo);
+	}
+
+	return type;
+}
+
+static void submitChild(replay_task_t *task)
+{
+	replay_type_t &type = getType(task->_typeId);
+
+	size_t flags = 0;
+	if (task->_flags & GraphRecordFormat::IF0_TASK)
+		flags |= nanos6_if_0_task;
+	if (task->_flags & GraphRecordFormat::WAIT_TASK)
+		flags |= nanos6_waiting_task;
+
+	replay_args_t *args;
+	void *handle;
+	nanos6_create_task(
+		&type._taskInfo, &_invocationInfo, type._label.c_str(),
+		sizeof(replay_args_t), (void **) &args, &handle,
+		flags, task->_accesses.size()
+	);
+
+	args->_task = task;
+	nanos6_submit_task(handle);
+}
+
+//! \brief Replay the execution of a task, creating its children and waiting for them
+//! after the recorded execution time
+static void replayTask(replay_task_t *task)
+{
+	uint64_t elapsed = 0;
+	for (const replay_step_t &step : task->_steps) {
+		if (step._offset > elapsed) {
+			Simulator::compute(step._offset - elapsed);
+			elapsed = step._offset;
+		}
+
+		if (step._child != nullptr) {
+			submitChild(step._child);
+		} else {
+			nanos6_taskwait("replayed taskwait");
+		}
+	}
+
+	if (task->_duration > elapsed)
+		Simulator::compute(task->_duration - elapsed);
+}
+
+static void usage(const char *program)
+{
+	std::cerr << "Usage: " << program << " [-w workers] [-p fifo|lifo] graph-file" << std::endl;
+	std::cerr << "  -w  Number of simulated workers (default: number of online CPUs)" << std::endl;
+	std::cerr << "  -p  Order of the ready tasks with the same priority (default: fifo)" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+	Simulator::policy_t policy = Simulator::FIFO_POLICY;
+
+	int option;
+	while ((option = getopt(argc, argv, "w:p:h")) != -1) {
+		switch (option) {
+			case 'w':
+				workers = atol(optarg);
+				break;
+			case 'p':
+				if (strcmp(optarg, "fifo") == 0)
+					policy = Simulator::FIFO_POLICY;
+				else if (strcmp(optarg, "lifo") == 0)
+					policy = Simulator::LIFO_POLICY;
+				else
+					usage(argv[0]);
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	if (optind != argc - 1 || workers <= 0)
+		usage(argv[0]);
+
+	loadGraph(argv[optind]);
+	std::vector<replay_task_t *> roots = linkGraph();
+
+	size_t numTasks = 0;
+	uint64_t totalDuration = 0;
+	for (auto &entry : _tasks) {
+		if (entry.second._recorded) {
+			numTasks++;
+			totalDuration += entry.second._duration;
+		}
+	}
+
+	Simulator::configure((size_t) workers, policy);
+
+	nanos6_init();
+
+	// Tasks without parent were spawned functions or created from external threads
+	for (replay_task_t *root : roots) {
+		nanos6_spawn_function(runRoot, root, nullptr, nullptr, _types[root->_typeId]._label.c_str());
+	}
+
+	Simulator::run();
+
+	nanos6_shutdown();
+
+	const Simulator::statistics_t &statistics = Simulator::getStatistics();
+	const double makespan = (double) statistics._makespan;
+	const double utilization = (makespan > 0) ? statistics._busyTime / (makespan * workers) : 0.0;
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Tasks:            " << numTasks << std::endl;
+	std::cout << "Executions:       " << statistics._executions << std::endl;
+	std::cout << "Workers:          " << workers << std::endl;
+	std::cout << "Policy:           " << ((policy == Simulator::FIFO_POLICY) ? "fifo" : "lifo") << std::endl;
+	std::cout << "Task time (ms):   " << totalDuration / 1e6 << std::endl;
+	std::cout << "Makespan (ms):    " << makespan / 1e6 << std::endl;
+	std::cout << "Speedup:          " << ((makespan > 0) ? totalDuration / makespan : 0.0) << std::endl;
+	std::cout << "Utilization:      " << utilization * 100.0 << " %" << std::endl;
+	std::cout << "Max ready tasks:  " << statistics._maxReady << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,389 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <sys/mman.h>
+
+#include "Simulator.hpp"
+#include "common/ErrorHandler.hpp"
+#include "hardware/CPUContext.hpp"
+#include "tasks/TaskMetadata.hpp"
+
+
+Simulator::policy_t Simulator::_policy = FIFO_POLICY;
+uint64_t Simulator::_now = 0;
+uint64_t Simulator::_sequence = 0;
+std::vector<nosv_task_t> Simulator::_workers;
+std::vector<nosv_task_t> Simulator::_immediate;
+std::priority_queue<Simulator::ready_entry_t, std::vector<Simulator::ready_entry_t>, Simulator::ready_order_t> Simulator::_ready;
+std::priority_queue<Simulator::event_t, std::vector<Simulator::event_t>, Simulator::event_order_t> Simulator::_events;
+nosv_task_t Simulator::_running = nullptr;
+nosv_task_t Simulator::_main = nullptr;
+ucontext_t Simulator::_mainContext;
+std::vector<char *> Simulator::_freeStacks;
+size_t Simulator::_liveContexts = 0;
+Simulator::statistics_t Simulator::_statistics = { 0, 0, 0, 0 };
+
+//! The type of the task attached to the main context, which has no callbacks
+static nosv_task_type _mainType = { nullptr, nullptr, nullptr, "main task", nullptr, nullptr };
+
+void Simulator::configure(size_t numWorkers, policy_t policy)
+{
+	assert(numWorkers > 0);
+
+	_policy = policy;
+	_workers.assign(numWorkers, nullptr);
+	_immediate.assign(numWorkers, nullptr);
+}
+
+void Simulator::run()
+{
+	assert(_running == nullptr);
+
+	while (true) {
+		dispatch();
+
+		if (_events.empty())
+			break;
+
+		event_t event = _events.top();
+		_events.pop();
+
+		assert(event._time >= _now);
+		_now = event._time;
+
+		if (event._holdsWorker) {
+			switchTo(event._task);
+		} else {
+			enqueue(event._task);
+		}
+	}
+
+	_statistics._makespan = _now;
+
+	ErrorHandler::warnIf(_liveContexts > 0, "The simulation ended with ", _liveContexts, " blocked tasks");
+}
+
+void Simulator::compute(uint64_t ns)
+{
+	ErrorHandler::failIf(_running == nullptr, "Only tasks can spend simulated time");
+	assert(_running->_worker >= 0);
+
+	if (ns == 0)
+		return;
+
+	_statistics._busyTime += ns;
+	_events.push({ _now + ns, _sequence++, _running, true });
+
+	leaveContext();
+}
+
+void Simulator::enqueue(nosv_task_t task)
+{
+	_ready.push({ task->_priority, _sequence++, task });
+	_statistics._maxReady = std::max(_statistics._maxReady, _ready.size());
+}
+
+void Simulator::releaseWorker(nosv_task_t owner)
+{
+	if (owner->_worker >= 0) {
+		assert(_workers[owner->_worker] == owner);
+		_workers[owner->_worker] = nullptr;
+		owner->_worker = -1;
+	}
+}
+
+void Simulator::execute(nosv_task_t task, nosv_task_t owner)
+{
+	nosv_task_t previousSelf = owner->_self;
+	owner->_self = task;
+	task->_owner = owner;
+	task->_suspended = false;
+	task->_events++;
+
+	_statistics._executions++;
+
+	task->_type->_run(task);
+
+	if (task->_suspended) {
+		// The task runs again from the beginning when resubmitted
+		task->_events--;
+		if (task->_suspendMode == NOSV_SUSPEND_MODE_TIMEOUT_SUBMIT) {
+			_events.push({ _now + task->_suspendArgs, _sequence++, task, false });
+		} else if (task->_suspendMode != NOSV_SUSPEND_MODE_NONE) {
+			enqueue(task);
+		}
+	} else {
+		if (task->_type->_end != nullptr)
+			task->_type->_end(task);
+
+		// The task may be destroyed by its completion
+		decreaseEvents(task, 1);
+	}
+
+	owner->_self = previousSelf;
+}
+
+void Simulator::contextEntry()
+{
+	nosv_task_t owner = _running;
+	assert(owner != nullptr);
+
+	execute(owner, owner);
+
+	// Returning resumes the main context through uc_link
+	owner->_contextDone = true;
+}
+
+void Simulator::switchTo(nosv_task_t owner)
+{
+	assert(_running == nullptr);
+	assert(owner->_worker >= 0);
+
+	if (owner->_stack == nullptr) {
+		if (_freeStacks.empty()) {
+			void *stack = mmap(nullptr, STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			ErrorHandler::failIf(stack == MAP_FAILED, "Could not allocate the stack of a simulated task");
+			_freeStacks.push_back((char *) stack);
+		}
+
+		owner->_stack = _freeStacks.back();
+		_freeStacks.pop_back();
+		_liveContexts++;
+
+		getcontext(&owner->_context);
+		owner->_context.uc_stack.ss_sp = owner->_stack;
+		owner->_context.uc_stack.ss_size = STACK_SIZE;
+		owner->_context.uc_link = &_mainContext;
+		makecontext(&owner->_context, &Simulator::contextEntry, 0);
+
+		owner->_self = nullptr;
+		owner->_currentTaskMetadata = nullptr;
+		owner->_lastTask = nullptr;
+	}
+
+	// Each context keeps its own per-thread state of the runtime, as a nOS-V worker would
+	TaskMetadata *mainCurrentTask = TaskMetadata::getCurrentTask();
+	nosv_task_t mainLastTask = TaskMetadata::getLastTask();
+	TaskMetadata::setCurrentTask(owner->_currentTaskMetadata);
+	TaskMetadata::setLastTask(owner->_lastTask);
+	CPUContext::invalidate();
+
+	_running = owner;
+	swapcontext(&_mainContext, &owner->_context);
+	_running = nullptr;
+
+	owner->_currentTaskMetadata = TaskMetadata::getCurrentTask();
+	owner->_lastTask = TaskMetadata::getLastTask();
+	TaskMetadata::setCurrentTask(mainCurrentTask);
+	TaskMetadata::setLastTask(mainLastTask);
+	CPUContext::invalidate();
+
+	if (owner->_contextDone) {
+		releaseWorker(owner);
+
+		_freeStacks.push_back(owner->_stack);
+		owner->_stack = nullptr;
+		owner->_contextDone = false;
+		_liveContexts--;
+
+		if (owner->_destroyPending) {
+			free(owner->_metadata);
+			delete owner;
+		}
+	}
+}
+
+void Simulator::leaveContext()
+{
+	assert(_running != nullptr);
+
+	swapcontext(&_running->_context, &_mainContext);
+}
+
+void Simulator::dispatch()
+{
+	for (size_t worker = 0; worker < _workers.size(); ++worker) {
+		while (_workers[worker] == nullptr) {
+			nosv_task_t task = _immediate[worker];
+			if (task != nullptr) {
+				_immediate[worker] = nullptr;
+			} else if (!_ready.empty()) {
+				task = _ready.top()._task;
+				_ready.pop();
+			} else {
+				break;
+			}
+
+			_workers[worker] = task;
+			task->_worker = (int) worker;
+			switchTo(task);
+		}
+	}
+}
+
+nosv_task_t Simulator::createTask(nosv_task_type_t type, size_t metadataSize)
+{
+	nosv_task_t task = new nosv_task();
+	task->_type = type;
+	task->_metadata = (metadataSize > 0) ? calloc(1, metadataSize) : nullptr;
+	task->_suspendMode = NOSV_SUSPEND_MODE_NONE;
+	task->_owner = task;
+	task->_worker = -1;
+
+	ErrorHandler::failIf(metadataSize > 0 && task->_metadata == nullptr, "Could not allocate the metadata of a task");
+
+	return task;
+}
+
+void Simulator::destroyTask(nosv_task_t task)
+{
+	// A task is usually destroyed within its own completion, while its context is alive
+	if (task->_stack != nullptr) {
+		task->_destroyPending = true;
+		return;
+	}
+
+	free(task->_metadata);
+	delete task;
+}
+
+void Simulator::attach(nosv_task_t *task)
+{
+	assert(_main == nullptr);
+
+	_main = createTask(&_mainType, 0);
+	_main->_self = _main;
+	*task = _main;
+}
+
+void Simulator::detach()
+{
+	assert(_main != nullptr);
+
+	destroyTask(_main);
+	_main = nullptr;
+}
+
+nosv_task_t Simulator::self()
+{
+	if (_running != nullptr)
+		return _running->_self;
+
+	return (_main != nullptr) ? _main->_self : nullptr;
+}
+
+int Simulator::getCurrentWorker()
+{
+	// The main context is considered to run in the first worker
+	if (_running == nullptr)
+		return 0;
+
+	assert(_running->_worker >= 0);
+	return _running->_worker;
+}
+
+void Simulator::submit(nosv_task_t task, nosv_flags_t flags)
+{
+	if (flags & NOSV_SUBMIT_UNLOCKED) {
+		nosv_task_t owner = task->_owner;
+		if (owner->_paused) {
+			owner->_paused = false;
+			enqueue(owner);
+		} else {
+			owner->_wakeupPending = true;
+		}
+	} else if (flags & NOSV_SUBMIT_INLINE) {
+		execute(task, (_running != nullptr) ? _running : _main);
+	} else if ((flags & NOSV_SUBMIT_IMMEDIATE) && _running != nullptr && _immediate[_running->_worker] == nullptr) {
+		_immediate[_running->_worker] = task;
+	} else {
+		enqueue(task);
+	}
+}
+
+void Simulator::pause()
+{
+	nosv_task_t owner = (_running != nullptr) ? _running : _main;
+	assert(owner != nullptr);
+
+	if (owner->_wakeupPending) {
+		owner->_wakeupPending = false;
+		return;
+	}
+
+	// The main context does not take part in the simulation, so it runs the simulation
+	// until the end instead of blocking
+	if (_running == nullptr) {
+		run();
+
+		ErrorHandler::failIf(!_main->_wakeupPending, "The simulation ended while the main task was blocked");
+		_main->_wakeupPending = false;
+		return;
+	}
+
+	_running->_paused = true;
+	releaseWorker(_running);
+	leaveContext();
+}
+
+void Simulator::yield()
+{
+	if (_running == nullptr || _ready.empty())
+		return;
+
+	releaseWorker(_running);
+	enqueue(_running);
+	leaveContext();
+}
+
+void Simulator::waitFor(uint64_t ns)
+{
+	if (_running == nullptr) {
+		run();
+		return;
+	}
+
+	releaseWorker(_running);
+	_events.push({ _now + ns, _sequence++, _running, false });
+	leaveContext();
+}
+
+void Simulator::suspend()
+{
+	nosv_task_t task = self();
+	assert(task != nullptr);
+
+	task->_suspended = true;
+}
+
+void Simulator::setSuspendMode(nosv_suspend_mode_t mode, uint64_t args)
+{
+	nosv_task_t task = self();
+	assert(task != nullptr);
+
+	task->_suspendMode = mode;
+	task->_suspendArgs = args;
+}
+
+void Simulator::increaseEvents(uint64_t increment)
+{
+	nosv_task_t task = self();
+	assert(task != nullptr);
+
+	task->_events += increment;
+}
+
+void Simulator::decreaseEvents(nosv_task_t task, uint64_t decrement)
+{
+	assert(task->_events >= decrement);
+
+	task->_events -= decrement;
+	if (task->_events == 0 && task->_type->_completed != nullptr)
+		task->_type->_completed(task);
+}
@@ -0,0 +1,249 @@
+/*
+	This file is part of NODES and is licensed under the terms contained in the COPYING file.
+
+	Copyright (C) 2024 Barcelona Supercomputing Center (BSC)
+*/
+
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <vector>
+#include <ucontext.h>
+
+#include <nosv.h>
+#include <nosv/affinity.h>
+
+
+class TaskMetadata;
+
+struct nosv_task_type {
+	nosv_task_run_callback_t _run;
+	nosv_task_end_callback_t _end;
+	nosv_task_completed_callback_t _completed;
+	std::string _label;
+	void *_metadata;
+	nosv_cost_function_t _cost;
+};
+
+struct nosv_task {
+	nosv_task_type_t _type;
+	void *_metadata;
+	int _priority;
+	nosv_affinity_t _affinity;
+
+	//! Number of events that prevent the completion of the task, including one while it runs
+	uint64_t _events;
+
+	//! Whether the task called nosv_suspend in its last execution, and how to resubmit it
+	bool _suspended;
+	nosv_suspend_mode_t _suspendMode;
+	uint64_t _suspendArgs;
+
+	//! The task that owns the execution context in which this task runs, which is the task
+	//! itself unless it runs inline within another task
+	nosv_task_t _owner;
+
+	//! The fields below are only used by the owners of execution contexts
+
+	ucontext_t _context;
+
+	//! The stack of the context, or nullptr if the task has no context
+	char *_stack;
+
+	//! Whether the context returned and its stack can be released
+	bool _contextDone;
+
+	//! The simulated worker that runs the context, or -1 if none
+	int _worker;
+
+	//! Whether the context is paused, and whether it was resumed before pausing
+	bool _paused;
+	bool _wakeupPending;
+
+	//! The innermost task that runs in the context
+	nosv_task_t _self;
+
+	//! The per-thread state of the runtime in the context
+	TaskMetadata *_currentTaskMetadata;
+	nosv_task_t _lastTask;
+
+	//! Whether the task was destroyed while its context was alive
+	bool _destroyPending;
+};
+
+//! Discrete-event simulation of the nOS-V scheduler with a pool of workers, on top of which
+//! the runtime runs unmodified within a single thread. Each task runs in its own execution
+//! context, which switches back to the simulation loop whenever the task spends simulated
+//! time, blocks or finishes. Time only advances through compute, so the cost of the runtime
+//! itself is not simulated
+class Simulator {
+
+public:
+
+	enum policy_t {
+		FIFO_POLICY = 0,
+		LIFO_POLICY
+	};
+
+	struct statistics_t {
+		//! Simulated time when the last task finished, in nanoseconds
+		uint64_t _makespan;
+
+		//! Simulated time that the workers spent computing, in nanoseconds
+		uint64_t _busyTime;
+
+		//! Number of task executions
+		size_t _executions;
+
+		//! Maximum number of ready tasks waiting for a worker
+		size_t _maxReady;
+	};
+
+private:
+
+	struct ready_entry_t {
+		int _priority;
+		uint64_t _sequence;
+		nosv_task_t _task;
+	};
+
+	//! Tasks with higher priority go first, and ties are broken according to the policy
+	struct ready_order_t {
+		bool operator()(const ready_entry_t &a, const ready_entry_t &b) const
+		{
+			if (a._priority != b._priority)
+				return a._priority < b._priority;
+
+			return (_policy == FIFO_POLICY) ? a._sequence > b._sequence : a._sequence < b._sequence;
+		}
+	};
+
+	struct event_t {
+		uint64_t _time;
+		uint64_t _sequence;
+		nosv_task_t _task;
+
+		//! Whether the task keeps its worker until the event, or becomes ready at that time
+		bool _holdsWorker;
+	};
+
+	struct event_order_t {
+		bool operator()(const event_t &a, const event_t &b) const
+		{
+			if (a._time != b._time)
+				return a._time > b._time;
+
+			return a._sequence > b._sequence;
+		}
+	};
+
+	//! Size of the stacks of the execution contexts, which are only committed when used
+	static const size_t STACK_SIZE = 1024 * 1024;
+
+	static policy_t _policy;
+
+	static uint64_t _now;
+
+	//! Sequence to order ready tasks and events deterministically
+	static uint64_t _sequence;
+
+	//! The context that each worker runs, or nullptr if the worker is idle
+	static std::vector<nosv_task_t> _workers;
+
+	//! Tasks submitted with NOSV_SUBMIT_IMMEDIATE, which each worker runs next
+	static std::vector<nosv_task_t> _immediate;
+
+	static std::priority_queue<ready_entry_t, std::vector<ready_entry_t>, ready_order_t> _ready;
+	static std::priority_queue<event_t, std::vector<event_t>, event_order_t> _events;
+
+	//! The owner of the running context, or nullptr while the main context runs
+	static nosv_task_t _running;
+
+	//! The task attached to the main context
+	static nosv_task_t _main;
+
+	static ucontext_t _mainContext;
+
+	static std::vector<char *> _freeStacks;
+
+	//! Number of contexts that are alive
+	static size_t _liveContexts;
+
+	static statistics_t _statistics;
+
+	static void enqueue(nosv_task_t task);
+
+	static void releaseWorker(nosv_task_t owner);
+
+	//! \brief Run a task until it ends or suspends in the context of owner
+	static void execute(nosv_task_t task, nosv_task_t owner);
+
+	//! \brief Entry point of the execution contexts
+	static void contextEntry();
+
+	//! \brief Start a task in a new context, or resume its context
+	static void switchTo(nosv_task_t owner);
+
+	//! \brief Go back to the main context from the running context
+	static void leaveContext();
+
+	//! \brief Assign the ready tasks to the idle workers
+	static void dispatch();
+
+public:
+
+	//! \brief Set the number of workers and the scheduling policy, before nosv_init
+	static void configure(size_t numWorkers, policy_t policy);
+
+	//! \brief Run the simulation until no task can make progress
+	static void run();
+
+	//! \brief Spend simulated time in the running task, keeping its worker
+	static void compute(uint64_t ns);
+
+	static inline size_t getNumWorkers()
+	{
+		return _workers.size();
+	}
+
+	static inline const statistics_t &getStatistics()
+	{
+		return _statistics;
+	}
+
+	//! nOS-V services
+
+	static nosv_task_t createTask(nosv_task_type_t type, size_t metadataSize);
+
+	static void destroyTask(nosv_task_t task);
+
+	static void attach(nosv_task_t *task);
+
+	static void detach();
+
+	static nosv_task_t self();
+
+	static int getCurrentWorker();
+
+	static void submit(nosv_task_t task, nosv_flags_t flags);
+
+	static void pause();
+
+	static void yield();
+
+	static void waitFor(uint64_t ns);
+
+	static void suspend();
+
+	static void setSuspendMode(nosv_suspend_mode_t mode, uint64_t args);
+
+	static void increaseEvents(uint64_t increment);
+
+	static void decreaseEvents(nosv_task_t task, uint64_t decrement);
+};
+
+#endif // SIMULATOR_HPP